@@ -0,0 +1,197 @@
+#include "pch.h"
+#include "benchmark.h"
+#include "parser.h"
+#include "c_lexer.h"
+#include "include_scanner.h"
+#include "stat_batch.h"
+
+#include <chrono>
+
+namespace CBuild {
+
+	void Benchmark::find_project_files(Parser& _parser, std::vector<std::filesystem::path>& _files) {
+
+		std::vector<std::filesystem::path> dir_files;
+
+		for (const std::filesystem::path& src_dir : _parser.src_dirs) {
+
+			if (File::find_files(src_dir, ".c", dir_files)) _files.insert(_files.end(), dir_files.begin(), dir_files.end());
+			if (File::find_files(src_dir, ".h", dir_files)) _files.insert(_files.end(), dir_files.begin(), dir_files.end());
+
+		}
+
+		for (const std::filesystem::path& incl_dir : _parser.incl_dirs) {
+			if (File::find_files(incl_dir, ".h", dir_files)) _files.insert(_files.end(), dir_files.begin(), dir_files.end());
+		}
+
+		_files.insert(_files.end(), _parser.src_files.begin(), _parser.src_files.end());
+
+	}
+
+	void Benchmark::run_include_scanner(Parser& _parser) {
+
+		std::vector<std::filesystem::path> files;
+		find_project_files(_parser, files);
+
+		std::vector<std::string> sources;
+		u64 total_bytes = 0;
+
+		for (const std::filesystem::path& file : files) {
+
+			std::string source;
+			if (!File::read_text_file(file, source)) continue;
+
+			total_bytes += source.length();
+			sources.push_back(source);
+
+		}
+
+		if (total_bytes <= 0) {
+
+			CBUILD_WARN("No source or header files found to benchmark.");
+			return;
+
+		}
+
+		//Repeat until roughly 64 MB have gone through each scanner, so small projects still give stable numbers.
+		u64 iterations = std::max<u64>(1, (64 * 1024 * 1024) / total_bytes);
+
+		C_Lexer c_lexer;
+		std::vector<Directive> directives;
+
+		u64 lexer_includes = 0;
+		u64 scanner_includes = 0;
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (u64 i = 0; i < iterations; ++i) {
+
+			for (const std::string& source : sources) {
+
+				c_lexer.clear();
+				c_lexer.parse_source(source);
+
+				if (i == 0) lexer_includes += c_lexer.include_indices.size();
+
+			}
+
+		}
+
+		f64 lexer_time = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+
+		for (u64 i = 0; i < iterations; ++i) {
+
+			for (const std::string& source : sources) {
+
+				Include_Scanner::scan(source, directives);
+				if (i == 0) scanner_includes += std::count_if(directives.begin(), directives.end(), [](const Directive& _directive) { return _directive.type == Directive_Type::Include; });
+
+			}
+
+		}
+
+		f64 scanner_time = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+
+		f64 megabytes = (f64)(total_bytes * iterations) / (1024.0 * 1024.0);
+		f64 lexer_speed = megabytes / std::max(lexer_time, 1e-9);
+		f64 scanner_speed = megabytes / std::max(scanner_time, 1e-9);
+
+		const char* simd = "scalar";
+#if defined(__AVX2__)
+		simd = "AVX2";
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		simd = "SSE2";
+#endif
+
+		CBUILD_TRACE("Scanned {} files ({} bytes) {} times.", sources.size(), total_bytes, iterations);
+		CBUILD_TRACE("C_Lexer:         {:.1f} MB/s, {} includes", lexer_speed, lexer_includes);
+		CBUILD_TRACE("Include_Scanner: {:.1f} MB/s, {} includes ({})", scanner_speed, scanner_includes, simd);
+		CBUILD_TRACE("Speedup:         {:.1f}x", scanner_speed / std::max(lexer_speed, 1e-9));
+
+	}
+
+	void Benchmark::run_stat(Parser& _parser, u32 _job_count) {
+
+		std::vector<std::filesystem::path> files;
+		find_project_files(_parser, files);
+
+		if (files.empty()) {
+
+			CBUILD_WARN("No source or header files found to benchmark.");
+			return;
+
+		}
+
+		//Repeat until roughly 100000 files have been checked by each method.
+		u64 iterations = std::max<u64>(1, 100000 / files.size());
+
+		Job_Pool job_pool(_job_count);
+		std::vector<File_Info> infos;
+
+		//What an up-to-date check used to cost per file: an exists check, the timestamp and the size.
+		u64 total_bytes = 0;
+		auto start = std::chrono::steady_clock::now();
+
+		for (u64 i = 0; i < iterations; ++i) {
+
+			for (const std::filesystem::path& file : files) {
+
+				std::error_code error;
+				if (!File::file_exists(file)) continue;
+
+				(void)std::filesystem::last_write_time(file, error);
+				u64 size = (u64)std::filesystem::file_size(file, error);
+				if (i == 0) total_bytes += size;
+
+			}
+
+		}
+
+		f64 filesystem_time = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+
+		for (u64 i = 0; i < iterations; ++i) {
+			Stat_Batch::stat_sequential(files, infos);
+		}
+
+		f64 sequential_time = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+
+		for (u64 i = 0; i < iterations; ++i) {
+			Stat_Batch::stat_thread_pool(files, infos, job_pool);
+		}
+
+		f64 thread_pool_time = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+
+		bool io_uring = Stat_Batch::io_uring_available();
+		f64 io_uring_time = 0.0;
+
+		if (io_uring) {
+
+			start = std::chrono::steady_clock::now();
+
+			for (u64 i = 0; i < iterations; ++i) {
+				Stat_Batch::stat_io_uring(files, infos);
+			}
+
+			io_uring_time = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+
+		}
+
+		f64 checks = (f64)(files.size() * iterations);
+
+		CBUILD_TRACE("Checked {} files ({} bytes) {} times.", files.size(), total_bytes, iterations);
+		CBUILD_TRACE("std::filesystem: {:.3f} us/file", filesystem_time * 1e6 / checks);
+		CBUILD_TRACE("Sequential stat: {:.3f} us/file, {:.1f}x", sequential_time * 1e6 / checks, filesystem_time / std::max(sequential_time, 1e-9));
+		CBUILD_TRACE("Thread pool:     {:.3f} us/file, {:.1f}x ({} jobs)", thread_pool_time * 1e6 / checks, filesystem_time / std::max(thread_pool_time, 1e-9), job_pool.workers.size());
+
+		if (io_uring) CBUILD_TRACE("io_uring:        {:.3f} us/file, {:.1f}x", io_uring_time * 1e6 / checks, filesystem_time / std::max(io_uring_time, 1e-9));
+		else CBUILD_TRACE("io_uring:        unavailable");
+
+	}
+
+}
\ No newline at end of file
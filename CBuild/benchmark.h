@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "types.h"
+
+namespace CBuild {
+
+	struct Parser;
+
+	struct Benchmark {
+
+		static void find_project_files(Parser& _parser, std::vector<std::filesystem::path>& _files);
+		static void run_include_scanner(Parser& _parser);
+		static void run_stat(Parser& _parser, u32 _job_count);
+
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include "pch.h"
+#include "build_graph.h"
+
+#include <algorithm>
+
+namespace CBuild {
+
+	Build_Graph::Build_Graph(u32 _job_count) : job_pool(_job_count) {}
+
+	Build_Graph::~Build_Graph() {
+
+		//Running jobs still reference the nodes, so let them finish before the nodes are destroyed.
+		job_pool.wait();
+
+	}
+
+	u64 Build_Graph::add_node(const std::string& _name, std::function<bool(Process_Result&)> _callback, const std::vector<u64>& _deps, const std::string& _error_message) {
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		u64 index = nodes.size();
+
+		Build_Node& node = nodes.emplace_back();
+		node.name = _name;
+		node.error_message = _error_message;
+		node.callback = _callback;
+
+		//Only count dependencies that have not finished yet, so nodes can be added while the graph is running.
+		for (u64 dep : _deps) {
+
+			if (dep >= index) continue;
+
+			Build_Node& dep_node = nodes[dep];
+			if (dep_node.state == Job_State::Succeeded) continue;
+
+			dep_node.dependents.push_back(index);
+			++node.remaining_deps;
+
+		}
+
+		if (started && node.remaining_deps <= 0) submit_node(index);
+
+		return index;
+
+	}
+
+	void Build_Graph::start() {
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if (started) return;
+		started = true;
+
+		for (u64 i = 0; i < nodes.size(); ++i) {
+			if (nodes[i].remaining_deps <= 0) submit_node(i);
+		}
+
+	}
+
+	bool Build_Graph::wait() {
+
+		start();
+
+		//Nodes are only ever submitted by the graph while holding its mutex, and a finishing node submits its dependents
+		//before its own job completes, so once the pool is idle nothing else can become ready.
+		job_pool.wait();
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for (const Build_Node& node : nodes) {
+			if (node.state != Job_State::Succeeded) return false;
+		}
+
+		return true;
+
+	}
+
+	const Build_Node* Build_Graph::get_first_failed_node() {
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for (const Build_Node& node : nodes) {
+			if (node.state == Job_State::Failed) return &node;
+		}
+
+		return nullptr;
+
+	}
+
+	void Build_Graph::submit_node(u64 _index) {
+
+		Build_Node& node = nodes[_index];
+		node.state = Job_State::Running;
+
+		job_pool.submit(node.name, [this, _index]() {
+
+			std::function<bool(Process_Result&)> callback;
+			Process_Result* result = nullptr;
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				callback = nodes[_index].callback;
+				result = &nodes[_index].result; //Deque elements keep their address while nodes are added.
+			}
+
+			bool success = callback(*result);
+
+			std::lock_guard<std::mutex> lock(mutex);
+
+			Build_Node& node = nodes[_index];
+			node.state = success ? Job_State::Succeeded : Job_State::Failed;
+
+			if (!success) return false;
+
+			for (u64 dependent : node.dependents) {
+
+				Build_Node& dependent_node = nodes[dependent];
+				if (dependent_node.remaining_deps > 0 && --dependent_node.remaining_deps <= 0) submit_node(dependent);
+
+			}
+
+			return true;
+
+		});
+
+	}
+
+	void Build_Graph::print_stats(u64 _count) {
+
+		//Compiles, the archive and the link each have a process result, CPU time and peak memory are only reported outside of Windows.
+		std::lock_guard<std::mutex> lock(mutex);
+
+		std::vector<const Build_Node*> jobs;
+		u64 wall_time = 0;
+		u64 cpu_time = 0;
+
+		for (const Build_Node& node : nodes) {
+
+			if (!node.result.started) continue;
+
+			jobs.push_back(&node);
+			wall_time += node.result.wall_time;
+			cpu_time += node.result.user_time + node.result.system_time;
+
+		}
+
+		if (jobs.empty()) return;
+
+		std::sort(jobs.begin(), jobs.end(), [](const Build_Node* _a, const Build_Node* _b) { return _a->result.wall_time > _b->result.wall_time; });
+
+		CBUILD_TRACE("Jobs: {}, wall time: {:.2f} s, CPU time: {:.2f} s", jobs.size(), wall_time / 1e6, cpu_time / 1e6);
+
+		for (u64 i = 0; i < jobs.size() && i < _count; ++i) {
+
+			const Process_Result& result = jobs[i]->result;
+
+			if (result.max_rss > 0) CBUILD_TRACE("  {:.2f} s (user {:.2f} s, system {:.2f} s, {} MB) {}", result.wall_time / 1e6, result.user_time / 1e6, result.system_time / 1e6, result.max_rss / 1024, jobs[i]->name);
+			else CBUILD_TRACE("  {:.2f} s {}", result.wall_time / 1e6, jobs[i]->name);
+
+		}
+
+	}
+
+}
\ No newline at end of file
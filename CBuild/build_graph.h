@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <functional>
+
+#include "types.h"
+#include "job_pool.h"
+#include "process.h"
+
+namespace CBuild {
+
+	struct Build_Node {
+
+		std::string name = "";
+		std::string error_message = "";
+		std::function<bool(Process_Result&)> callback;
+		Process_Result result;
+		std::vector<u64> dependents;
+		u64 remaining_deps = 0;
+		Job_State state = Job_State::Pending;
+
+	};
+
+	struct Build_Graph {
+
+		Job_Pool job_pool;
+		std::deque<Build_Node> nodes;
+		std::mutex mutex;
+		bool started = false;
+
+		Build_Graph(u32 _job_count);
+		~Build_Graph();
+
+		u64 add_node(const std::string& _name, std::function<bool(Process_Result&)> _callback, const std::vector<u64>& _deps = {}, const std::string& _error_message = "");
+		void start();
+		bool wait();
+		const Build_Node* get_first_failed_node();
+		void submit_node(u64 _index);
+		void print_stats(u64 _count = 5);
+
+	};
+
+}
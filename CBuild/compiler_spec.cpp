@@ -1,31 +1,80 @@
 #include "pch.h"
 #include "compiler_spec.h"
 #include "parser.h"
+#include "hash.h"
 
 namespace CBuild {
 
 	Compiler_Spec::Compiler_Spec(Compiler_Type _type, const std::string _name, const std::string _archiver_name) : type(_type), name(_name), archiver_name(_archiver_name) {}
 
-	std::string Compiler_Spec::init_cmd(const std::string& _name, Parser& _parser) {
-		return "\"" + _parser.get_compiler_path(_name).string() + "\"";
+	std::vector<std::string> Compiler_Spec::init_cmd(const std::string& _name, Parser& _parser) {
+		return { _parser.get_compiler_path(_name).string() };
 	}
 
-	void Compiler_Spec::add_includes_and_libraries(std::string& _cmd, Parser& _parser) {
+	std::filesystem::path Compiler_Spec::get_dep_path(const std::filesystem::path _source, const Config_Type _config, Parser& _parser) {
+
+		return _parser.get_obj_path(_source, _config, ".d");
+
+	}
+
+	u64 Compiler_Spec::hash_cmd(const std::vector<std::string>& _cmd) {
+
+		//Lengths are mixed in, so arguments can't run into each other. ("-I a" and "-Ia")
+		u64 hash = Hash::seed;
+
+		for (const std::string& arg : _cmd) {
+			hash = Hash::combine(Hash::string(arg, hash), arg.length());
+		}
+
+		return hash;
+
+	}
+
+	void Compiler_Spec::add_predefined_macros(Preprocessor& _preprocessor, const Config_Type _config, Parser& _parser) {
+
+		//Macros of the platform CBuild runs on, which is also the platform being built for.
+#if defined(_WIN32)
+		_preprocessor.define("_WIN32", "1");
+		_preprocessor.define("WIN32", "1");
+		_preprocessor.define("WINNT", "1");
+		_preprocessor.forget("WIN64");
+
+		for (const char* name : { "__linux__", "__unix__", "__APPLE__", "__MACH__", "__CYGWIN__", "linux", "unix" }) _preprocessor.undefine(name);
+#elif defined(__APPLE__)
+		_preprocessor.define("__APPLE__", "1");
+		_preprocessor.define("__MACH__", "1");
+
+		for (const char* name : { "_WIN32", "_WIN64", "__CYGWIN__", "__MINGW32__", "__MINGW64__", "__linux__", "WIN32", "linux" }) _preprocessor.undefine(name);
+#elif defined(__linux__)
+		_preprocessor.define("__linux__", "1");
+		_preprocessor.define("__unix__", "1");
+		_preprocessor.define("linux", "1");
+		_preprocessor.define("unix", "1");
+		_preprocessor.forget("i386");
+
+		for (const char* name : { "_WIN32", "_WIN64", "__CYGWIN__", "__MINGW32__", "__MINGW64__", "__APPLE__", "__MACH__", "WIN32" }) _preprocessor.undefine(name);
+#endif
+
+		_preprocessor.undefine("_MSC_VER");
+
+	}
+
+	void Compiler_Spec::add_includes_and_libraries(std::vector<std::string>& _cmd, Parser& _parser) {
 
 		for (const std::filesystem::path& incl_dir : _parser.incl_dirs) {
-			_cmd += " -I \"" + incl_dir.string() + "\"";
+			_cmd.insert(_cmd.end(), { "-I", incl_dir.string() });
 		}
 
 		for (const std::filesystem::path& lib_dir : _parser.lib_dirs) {
-			_cmd += " -L \"" + lib_dir.string() + "\"";
+			_cmd.insert(_cmd.end(), { "-L", lib_dir.string() });
 		}
 
 		if (_parser.static_libs.size() > 0) {
 
-			_cmd += " -static";
+			_cmd.push_back("-static");
 
-			for (const std::string static_lib : _parser.static_libs) {
-				_cmd += " -l " + static_lib;
+			for (const std::string& static_lib : _parser.static_libs) {
+				_cmd.insert(_cmd.end(), { "-l", static_lib });
 			}
 
 		}
@@ -35,64 +84,74 @@ namespace CBuild {
 	//GCC.
 	Compiler_Spec_GCC::Compiler_Spec_GCC() : Compiler_Spec(Compiler_Type::GCC, "gcc", "ar") {}
 
-	void Compiler_Spec_GCC::add_common_flags(std::string& _cmd, const Config_Type _config, Parser& _parser) {
+	void Compiler_Spec_GCC::add_common_flags(std::vector<std::string>& _cmd, const Config_Type _config, Parser& _parser) {
+
+		if (_config == Config_Type::Debug)	_cmd.insert(_cmd.end(), { "-Wall", "-g", "-D", "DEBUG" });
+		else								_cmd.insert(_cmd.end(), { "-Wall", "-O3", "-D", "NDEBUG" });
+
+	}
+
+	void Compiler_Spec_GCC::add_predefined_macros(Preprocessor& _preprocessor, const Config_Type _config, Parser& _parser) {
+
+		Compiler_Spec::add_predefined_macros(_preprocessor, _config, _parser);
 
-		if (_config == Config_Type::Debug)	_cmd += " -Wall -g -D DEBUG";
-		else								_cmd += " -Wall -O3 -D NDEBUG";
+		_preprocessor.define_unknown("__GNUC__");
+		_preprocessor.undefine("__clang__");
+		_preprocessor.define((_config == Config_Type::Debug) ? "DEBUG" : "NDEBUG", "1");
 
 	}
 
-	std::string Compiler_Spec_GCC::build_source_cmd(const std::filesystem::path _source, const Config_Type _config, Parser& _parser) {
+	std::vector<std::string> Compiler_Spec_GCC::build_source_cmd(const std::filesystem::path _source, const Config_Type _config, Parser& _parser) {
 
-		std::string cmd = init_cmd(name, _parser);
+		std::vector<std::string> cmd = init_cmd(name, _parser);
 
 		add_common_flags(cmd, _config, _parser);
 		add_includes_and_libraries(cmd, _parser);
 
-		std::filesystem::path obj_path = _parser.get_obj_output_path(_config) / _source.filename().replace_extension(".o");
+		std::filesystem::path obj_path = _parser.get_obj_path(_source, _config);
 		File::format_path(obj_path);
 
-		cmd += " -c -o \"" + obj_path.string() + "\"";
-		cmd += " \"" + _source.string() + "\"";
+		cmd.insert(cmd.end(), { "-MMD", "-MP", "-MF", get_dep_path(_source, _config, _parser).string() });
+		cmd.insert(cmd.end(), { "-c", "-o", obj_path.string() });
+		cmd.push_back(_source.string());
 
-		return "\"" + cmd + "\"";
+		return cmd;
 
 	}
 
-	std::string Compiler_Spec_GCC::build_pch_cmd(const std::filesystem::path _pch, const Config_Type _config, Parser& _parser) {
+	std::vector<std::string> Compiler_Spec_GCC::build_pch_cmd(const std::filesystem::path _pch, const Config_Type _config, Parser& _parser) {
 
-		std::string cmd = init_cmd(name, _parser);
+		std::vector<std::string> cmd = init_cmd(name, _parser);
 		add_common_flags(cmd, _config, _parser);
 		add_includes_and_libraries(cmd, _parser);
 
 		std::filesystem::path gch_path = std::filesystem::path(_pch).replace_extension(".gch");
 
-		cmd += " -c \"" + _pch.string() + "\" -o \"" + gch_path.string() + "\"";
+		cmd.insert(cmd.end(), { "-c", _pch.string(), "-o", gch_path.string() });
 
-		return "\"" + cmd + "\"";
+		return cmd;
 
 	}
 
-	bool Compiler_Spec_GCC::build_binary(const std::filesystem::path _binary, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser) {
+	bool Compiler_Spec_GCC::build_binary(const std::filesystem::path _binary, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser, Process_Result& _result) {
 
-		std::string cmd = init_cmd(name, _parser);
+		std::vector<std::string> cmd = init_cmd(name, _parser);
 		add_common_flags(cmd, _config, _parser);
 
 		for (const std::filesystem::path& file : _obj_files) {
 
 			if (File::file_exists(file)) {
-				cmd += " \"" + file.string() + "\"";
+				cmd.push_back(file.string());
 			}
 
 		}
 
 		add_includes_and_libraries(cmd, _parser);
 
-		cmd += " -o \"" + _binary.string() + "\"";
-		cmd = "\"" + cmd + "\"";
+		cmd.insert(cmd.end(), { "-o", _binary.string() });
 
-		if (_print_cmds) CBUILD_TRACE(cmd);
-		if (system(cmd.c_str()) != 0) {
+		if (_print_cmds) CBUILD_TRACE(Process::args_to_string(cmd));
+		if (!Process::run(cmd, _result)) {
 
 			CBUILD_ERROR("Error occurred while linking binary.");
 			return false;
@@ -103,10 +162,10 @@ namespace CBuild {
 
 		if (_parser.run_binary) {
 
-			cmd = "cd " + _parser.get_build_output_path(_config).string() + " && \"" + _parser.build_name + "\"";
+			std::string run_cmd = "cd " + _parser.get_build_output_path(_config).string() + " && \"" + _parser.build_name + "\"";
 
-			if (_print_cmds) CBUILD_TRACE(cmd);
-			system(cmd.c_str());
+			if (_print_cmds) CBUILD_TRACE(run_cmd);
+			system(run_cmd.c_str());
 
 		}
 
@@ -114,23 +173,21 @@ namespace CBuild {
 
 	}
 
-	bool Compiler_Spec_GCC::build_static_lib(const std::filesystem::path _lib, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser) {
+	bool Compiler_Spec_GCC::build_static_lib(const std::filesystem::path _lib, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser, Process_Result& _result) {
 
-		std::string cmd = init_cmd(archiver_name, _parser);
-		cmd += " rcs \"" + _lib.string() + "\"";
+		std::vector<std::string> cmd = init_cmd(archiver_name, _parser);
+		cmd.insert(cmd.end(), { "rcs", _lib.string() });
 
 		for (const std::filesystem::path& file : _obj_files) {
 
 			if (File::file_exists(file)) {
-				cmd += " \"" + file.string() + "\"";
+				cmd.push_back(file.string());
 			}
 
 		}
 
-		cmd = "\"" + cmd + "\"";
-
-		if (_print_cmds) CBUILD_TRACE(cmd);
-		if (system(cmd.c_str()) != 0) {
+		if (_print_cmds) CBUILD_TRACE(Process::args_to_string(cmd));
+		if (!Process::run(cmd, _result)) {
 
 			CBUILD_ERROR("Error occurred while linking static library.");
 			return false;
@@ -146,61 +203,74 @@ namespace CBuild {
 	//AVR-GCC.
 	Compiler_Spec_AVR_GCC::Compiler_Spec_AVR_GCC() : Compiler_Spec(Compiler_Type::AVR_GCC, "avr-gcc", "avr-ar") {}
 
-	void Compiler_Spec_AVR_GCC::add_common_flags(std::string& _cmd, const Config_Type _config, Parser& _parser) {
+	void Compiler_Spec_AVR_GCC::add_common_flags(std::vector<std::string>& _cmd, const Config_Type _config, Parser& _parser) {
 
 	}
 
-	std::string Compiler_Spec_AVR_GCC::build_source_cmd(const std::filesystem::path _source, const Config_Type _config, Parser& _parser) {
+	void Compiler_Spec_AVR_GCC::add_predefined_macros(Preprocessor& _preprocessor, const Config_Type _config, Parser& _parser) {
+
+		//Nothing of the host platform applies to the microcontroller.
+		for (const char* name : { "_WIN32", "_WIN64", "__CYGWIN__", "__MINGW32__", "__MINGW64__", "__linux__", "__unix__", "__APPLE__", "__MACH__", "_MSC_VER", "__clang__", "WIN32", "linux", "unix" }) _preprocessor.undefine(name);
 
-		std::string cmd = init_cmd(name, _parser);
+		_preprocessor.define("__AVR__", "1");
+		_preprocessor.define("__AVR", "1");
+		_preprocessor.define("AVR", "1");
+		_preprocessor.define_unknown("__GNUC__");
+		_preprocessor.define((_config == Config_Type::Debug) ? "DEBUG" : "NDEBUG", "1");
+
+	}
+
+	std::vector<std::string> Compiler_Spec_AVR_GCC::build_source_cmd(const std::filesystem::path _source, const Config_Type _config, Parser& _parser) {
+
+		std::vector<std::string> cmd = init_cmd(name, _parser);
 
 		if (_config == Config_Type::Release) {
-			cmd += " -x c -funsigned-char -funsigned-bitfields -DNDEBUG  -I \"" + _parser.get_atmel_studio_include_path().string() + "\" -Os -ffunction-sections -fdata-sections -fpack-struct -fshort-enums -Wall -mmcu=" + _parser.avr_mcu + " -B \"" + _parser.get_atmel_studio_mcu_path().string() + "\" -c -std=gnu99";
+			cmd.insert(cmd.end(), { "-x", "c", "-funsigned-char", "-funsigned-bitfields", "-DNDEBUG", "-I", _parser.get_atmel_studio_include_path().string(), "-Os", "-ffunction-sections", "-fdata-sections", "-fpack-struct", "-fshort-enums", "-Wall", "-mmcu=" + _parser.avr_mcu, "-B", _parser.get_atmel_studio_mcu_path().string(), "-c", "-std=gnu99" });
 		}
 		else {
-			cmd += " -x c -funsigned-char -funsigned-bitfields -DDEBUG  -I \"" + _parser.get_atmel_studio_include_path().string() + "\" -Og -ffunction-sections -fdata-sections -fpack-struct -fshort-enums -g2 -Wall -mmcu=" + _parser.avr_mcu + " -B \"" + _parser.get_atmel_studio_mcu_path().string() + "\" -c -std=gnu99";
+			cmd.insert(cmd.end(), { "-x", "c", "-funsigned-char", "-funsigned-bitfields", "-DDEBUG", "-I", _parser.get_atmel_studio_include_path().string(), "-Og", "-ffunction-sections", "-fdata-sections", "-fpack-struct", "-fshort-enums", "-g2", "-Wall", "-mmcu=" + _parser.avr_mcu, "-B", _parser.get_atmel_studio_mcu_path().string(), "-c", "-std=gnu99" });
 		}
 
 		add_common_flags(cmd, _config, _parser);
 		add_includes_and_libraries(cmd, _parser);
 
-		std::filesystem::path obj_path = _parser.get_obj_output_path(_config) / _source.filename().replace_extension(".o");
+		std::filesystem::path obj_path = _parser.get_obj_path(_source, _config);
 		File::format_path(obj_path);
 
-		std::filesystem::path d_path = std::filesystem::path(obj_path).replace_extension(".d");
+		std::filesystem::path d_path = get_dep_path(_source, _config, _parser);
 
-		cmd += " -MD -MP -MF \"" + d_path.string() + "\" -MT \"" + d_path.string() + "\" -MT \"" + obj_path.string() + "\" -o \"" + obj_path.string() + "\"";
-		cmd += " \"" + _source.string() + "\"";
+		cmd.insert(cmd.end(), { "-MD", "-MP", "-MF", d_path.string(), "-MT", d_path.string(), "-MT", obj_path.string(), "-o", obj_path.string() });
+		cmd.push_back(_source.string());
 
-		return "\"" + cmd + "\"";
+		return cmd;
 
 	}
 
-	std::string Compiler_Spec_AVR_GCC::build_pch_cmd(const std::filesystem::path _pch, const Config_Type _config, Parser& _parser) {
+	std::vector<std::string> Compiler_Spec_AVR_GCC::build_pch_cmd(const std::filesystem::path _pch, const Config_Type _config, Parser& _parser) {
 
-		std::string cmd = init_cmd(name, _parser);
+		std::vector<std::string> cmd = init_cmd(name, _parser);
 		add_common_flags(cmd, _config, _parser);
 
 		if (_config == Config_Type::Release) {
-			cmd += " -x c -funsigned-char -funsigned-bitfields -DNDEBUG  -I \"" + _parser.get_atmel_studio_include_path().string() + "\" -Os -ffunction-sections -fdata-sections -fpack-struct -fshort-enums -Wall -mmcu=" + _parser.avr_mcu + " -B \"" + _parser.get_atmel_studio_mcu_path().string() + "\" -c -std=gnu99";
+			cmd.insert(cmd.end(), { "-x", "c", "-funsigned-char", "-funsigned-bitfields", "-DNDEBUG", "-I", _parser.get_atmel_studio_include_path().string(), "-Os", "-ffunction-sections", "-fdata-sections", "-fpack-struct", "-fshort-enums", "-Wall", "-mmcu=" + _parser.avr_mcu, "-B", _parser.get_atmel_studio_mcu_path().string(), "-c", "-std=gnu99" });
 		}
 		else {
-			cmd += " -x c -funsigned-char -funsigned-bitfields -DDEBUG  -I \"" + _parser.get_atmel_studio_include_path().string() + "\" -Og -ffunction-sections -fdata-sections -fpack-struct -fshort-enums -g2 -Wall -mmcu=" + _parser.avr_mcu + " -B \"" + _parser.get_atmel_studio_mcu_path().string() + "\" -c -std=gnu99";
+			cmd.insert(cmd.end(), { "-x", "c", "-funsigned-char", "-funsigned-bitfields", "-DDEBUG", "-I", _parser.get_atmel_studio_include_path().string(), "-Og", "-ffunction-sections", "-fdata-sections", "-fpack-struct", "-fshort-enums", "-g2", "-Wall", "-mmcu=" + _parser.avr_mcu, "-B", _parser.get_atmel_studio_mcu_path().string(), "-c", "-std=gnu99" });
 		}
 
 		add_includes_and_libraries(cmd, _parser);
 
 		std::filesystem::path gch_path = std::filesystem::path(_pch).replace_extension(".gch");
 
-		cmd += " \"" + _pch.string() + "\" -o \"" + gch_path.string() + "\"";
+		cmd.insert(cmd.end(), { _pch.string(), "-o", gch_path.string() });
 
-		return "\"" + cmd + "\"";
+		return cmd;
 
 	}
 
-	bool Compiler_Spec_AVR_GCC::build_binary(const std::filesystem::path _binary, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser) {
+	bool Compiler_Spec_AVR_GCC::build_binary(const std::filesystem::path _binary, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser, Process_Result& _result) {
 		
-		std::string cmd = init_cmd(name, _parser);
+		std::vector<std::string> cmd = init_cmd(name, _parser);
 		add_common_flags(cmd, _config, _parser);
 
 		std::filesystem::path elf_path = std::filesystem::path(_binary).replace_extension(".elf");
@@ -208,24 +278,22 @@ namespace CBuild {
 		std::filesystem::path hex_path = std::filesystem::path(_binary).replace_extension(".hex");
 		std::filesystem::path eep_path = std::filesystem::path(_binary).replace_extension(".eep");
 
-		cmd += " -o \"" + elf_path.string() + "\"";
+		cmd.insert(cmd.end(), { "-o", elf_path.string() });
 
 		for (const std::filesystem::path& file : _obj_files) {
 
 			if (File::file_exists(file)) {
-				cmd += " \"" + file.string() + "\"";
+				cmd.push_back(file.string());
 			}
 
 		}
 
-		cmd += " -Wl,-Map=\"" + map_path.string() + "\" -Wl,--start-group -Wl,-lm -Wl,--end-group -Wl,--gc-sections -mmcu=" + _parser.avr_mcu + " -B \"" + _parser.get_atmel_studio_mcu_path().string() + "\"";
+		cmd.insert(cmd.end(), { "-Wl,-Map=" + map_path.string(), "-Wl,--start-group", "-Wl,-lm", "-Wl,--end-group", "-Wl,--gc-sections", "-mmcu=" + _parser.avr_mcu, "-B", _parser.get_atmel_studio_mcu_path().string() });
 
 		add_includes_and_libraries(cmd, _parser);
 
-		cmd = "\"" + cmd + "\"";
-
-		if (_print_cmds) CBUILD_TRACE(cmd);
-		if (system(cmd.c_str()) != 0) {
+		if (_print_cmds) CBUILD_TRACE(Process::args_to_string(cmd));
+		if (!Process::run(cmd, _result)) {
 
 			CBUILD_ERROR("Error occurred while linking binary.");
 			return false;
@@ -234,36 +302,52 @@ namespace CBuild {
 
 		CBUILD_INFO("Generated '{}'", _binary.string() + ".elf");
 
-		cmd = "\"" + init_cmd("avr-size", _parser) + " \"" + elf_path.string() + "\"\"";
-		system(cmd.c_str());
+		//The size and hex steps count towards the link job, flashing the device doesn't.
+		auto run_step = [&_result](const std::vector<std::string>& _cmd) {
+
+			Process_Result step;
+			bool success = Process::run(_cmd, step);
 
-		cmd = "\"" + init_cmd("avr-objcopy", _parser) + " -O ihex -R .eeprom -R .fuse -R .lock -R .signature -R .user_signatures \"" + elf_path.string() + "\" \"" + hex_path.string() + "\"\"";
+			_result.add(step);
+			return success;
 
-		if (_print_cmds) CBUILD_TRACE(cmd);
-		if (system(cmd.c_str()) != 0) {
+		};
+
+		cmd = init_cmd("avr-size", _parser);
+		cmd.push_back(elf_path.string());
+		run_step(cmd);
+
+		cmd = init_cmd("avr-objcopy", _parser);
+		cmd.insert(cmd.end(), { "-O", "ihex", "-R", ".eeprom", "-R", ".fuse", "-R", ".lock", "-R", ".signature", "-R", ".user_signatures", elf_path.string(), hex_path.string() });
+
+		if (_print_cmds) CBUILD_TRACE(Process::args_to_string(cmd));
+		if (!run_step(cmd)) {
 			CBUILD_WARN("Error occurred while generating '{}'", hex_path.string());
 		}
 		else {
 
 			CBUILD_INFO("Generated '{}'", hex_path.string());
 
-			cmd = "\"" + init_cmd("avr-size", _parser) + " \"" + hex_path.string() + "\"\"";
-			system(cmd.c_str());
+			cmd = init_cmd("avr-size", _parser);
+			cmd.push_back(hex_path.string());
+			run_step(cmd);
 
 		}
 
-		cmd = "\"" + init_cmd("avr-objcopy", _parser) + " -j .eeprom  --set-section-flags=.eeprom=alloc,load --change-section-lma .eeprom=0  --no-change-warnings -O ihex \"" + elf_path.string() + "\" \"" + eep_path.string() + "\" || exit 0\"";
+		cmd = init_cmd("avr-objcopy", _parser);
+		cmd.insert(cmd.end(), { "-j", ".eeprom", "--set-section-flags=.eeprom=alloc,load", "--change-section-lma", ".eeprom=0", "--no-change-warnings", "-O", "ihex", elf_path.string(), eep_path.string() });
 
-		if (_print_cmds) CBUILD_TRACE(cmd);
-		if (system(cmd.c_str()) != 0) {
+		if (_print_cmds) CBUILD_TRACE(Process::args_to_string(cmd));
+		if (!run_step(cmd)) {
 			CBUILD_WARN("Error occurred while generating '{}'", eep_path.string());
 		}
 		else {
 			
 			CBUILD_INFO("Generated '{}'", eep_path.string());
 
-			cmd = "\"" + init_cmd("avr-size", _parser) + " \"" + eep_path.string() + "\"\"";
-			system(cmd.c_str());
+			cmd = init_cmd("avr-size", _parser);
+			cmd.push_back(eep_path.string());
+			run_step(cmd);
 
 		}
 
@@ -279,27 +363,27 @@ namespace CBuild {
 
 			}
 
-			cmd = "\"\"" + dfu_path.string() + "\" " + _parser.avr_mcu + " erase --force\"";
-			if (_print_cmds) CBUILD_TRACE(cmd);
-			if (system(cmd.c_str()) != 0) {
+			cmd = { dfu_path.string(), _parser.avr_mcu, "erase", "--force" };
+			if (_print_cmds) CBUILD_TRACE(Process::args_to_string(cmd));
+			if (!Process::run(cmd)) {
 
 				CBUILD_WARN("Error occurred while uploading to device.");
 				return true;
 
 			}
 
-			cmd = "\"\"" + dfu_path.string() + "\" " + _parser.avr_mcu + " flash \"" + hex_path.string() + "\"\"";
-			if (_print_cmds) CBUILD_TRACE(cmd);
-			if (system(cmd.c_str()) != 0) {
+			cmd = { dfu_path.string(), _parser.avr_mcu, "flash", hex_path.string() };
+			if (_print_cmds) CBUILD_TRACE(Process::args_to_string(cmd));
+			if (!Process::run(cmd)) {
 
 				CBUILD_WARN("Error occurred while uploading to device.");
 				return true;
 
 			}
 
-			cmd = "\"\"" + dfu_path.string() + "\" " + _parser.avr_mcu + " reset\"";
-			if (_print_cmds) CBUILD_TRACE(cmd);
-			if (system(cmd.c_str()) != 0) {
+			cmd = { dfu_path.string(), _parser.avr_mcu, "reset" };
+			if (_print_cmds) CBUILD_TRACE(Process::args_to_string(cmd));
+			if (!Process::run(cmd)) {
 
 				CBUILD_WARN("Error occurred while uploading to device.");
 				return true;
@@ -312,23 +396,21 @@ namespace CBuild {
 
 	}
 
-	bool Compiler_Spec_AVR_GCC::build_static_lib(const std::filesystem::path _lib, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser) {
+	bool Compiler_Spec_AVR_GCC::build_static_lib(const std::filesystem::path _lib, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser, Process_Result& _result) {
 
-		std::string cmd = init_cmd(archiver_name, _parser);
-		cmd += " rcs \"" + _lib.string() + "\"";
+		std::vector<std::string> cmd = init_cmd(archiver_name, _parser);
+		cmd.insert(cmd.end(), { "rcs", _lib.string() });
 
 		for (const std::filesystem::path& file : _obj_files) {
 
 			if (File::file_exists(file)) {
-				cmd += " \"" + file.string() + "\"";
+				cmd.push_back(file.string());
 			}
 
 		}
 
-		cmd = "\"" + cmd + "\"";
-
-		if (_print_cmds) CBUILD_TRACE(cmd);
-		if (system(cmd.c_str()) != 0) {
+		if (_print_cmds) CBUILD_TRACE(Process::args_to_string(cmd));
+		if (!Process::run(cmd, _result)) {
 
 			CBUILD_ERROR("Error occurred while linking static library.");
 			return false;
@@ -344,66 +426,75 @@ namespace CBuild {
 	}
 
 	//Clang.
-	void Compiler_Spec_Clang::add_common_flags(std::string& _cmd, const Config_Type _config, Parser& _parser) {
+	void Compiler_Spec_Clang::add_common_flags(std::vector<std::string>& _cmd, const Config_Type _config, Parser& _parser) {
 
-		if (_config == Config_Type::Debug)	_cmd += " -Wall -g";
-		else								_cmd += " -Wall -O3";
+		if (_config == Config_Type::Debug)	_cmd.insert(_cmd.end(), { "-Wall", "-g" });
+		else								_cmd.insert(_cmd.end(), { "-Wall", "-O3" });
 
 	}
 
 	Compiler_Spec_Clang::Compiler_Spec_Clang() : Compiler_Spec(Compiler_Type::Clang, "clang", "llvm-ar") {}
 
-	std::string Compiler_Spec_Clang::build_source_cmd(const std::filesystem::path _source, const Config_Type _config, Parser& _parser) {
+	void Compiler_Spec_Clang::add_predefined_macros(Preprocessor& _preprocessor, const Config_Type _config, Parser& _parser) {
+
+		Compiler_Spec::add_predefined_macros(_preprocessor, _config, _parser);
 
-		std::string cmd = init_cmd(name, _parser);
+		_preprocessor.define_unknown("__clang__");
+		_preprocessor.define_unknown("__GNUC__");
+
+	}
+
+	std::vector<std::string> Compiler_Spec_Clang::build_source_cmd(const std::filesystem::path _source, const Config_Type _config, Parser& _parser) {
+
+		std::vector<std::string> cmd = init_cmd(name, _parser);
 
 		add_common_flags(cmd, _config, _parser);
 		add_includes_and_libraries(cmd, _parser);
 
-		std::filesystem::path obj_path = _parser.get_obj_output_path(_config) / _source.filename().replace_extension(".o");
+		std::filesystem::path obj_path = _parser.get_obj_path(_source, _config);
 		File::format_path(obj_path);
 
-		cmd += " -c -o \"" + obj_path.string() + "\"";
-		cmd += " \"" + _source.string() + "\"";
+		cmd.insert(cmd.end(), { "-MMD", "-MP", "-MF", get_dep_path(_source, _config, _parser).string() });
+		cmd.insert(cmd.end(), { "-c", "-o", obj_path.string() });
+		cmd.push_back(_source.string());
 
-		return "\"" + cmd + "\"";
+		return cmd;
 
 	}
 
-	std::string Compiler_Spec_Clang::build_pch_cmd(const std::filesystem::path _pch, const Config_Type _config, Parser& _parser) {
+	std::vector<std::string> Compiler_Spec_Clang::build_pch_cmd(const std::filesystem::path _pch, const Config_Type _config, Parser& _parser) {
 
-		std::string cmd = init_cmd(name, _parser);
+		std::vector<std::string> cmd = init_cmd(name, _parser);
 		add_common_flags(cmd, _config, _parser);
 		add_includes_and_libraries(cmd, _parser);
 
 		std::filesystem::path gch_path = std::filesystem::path(_pch).replace_extension(".gch");
 
-		cmd += " -c \"" + _pch.string() + "\" -o \"" + gch_path.string() + "\"";
+		cmd.insert(cmd.end(), { "-c", _pch.string(), "-o", gch_path.string() });
 
-		return "\"" + cmd + "\"";
+		return cmd;
 
 	}
 
-	bool Compiler_Spec_Clang::build_binary(const std::filesystem::path _binary, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser) {
+	bool Compiler_Spec_Clang::build_binary(const std::filesystem::path _binary, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser, Process_Result& _result) {
 		
-		std::string cmd = init_cmd(name, _parser);
+		std::vector<std::string> cmd = init_cmd(name, _parser);
 		add_common_flags(cmd, _config, _parser);
 
 		for (const std::filesystem::path& file : _obj_files) {
 
 			if (File::file_exists(file)) {
-				cmd += " \"" + file.string() + "\"";
+				cmd.push_back(file.string());
 			}
 
 		}
 
 		add_includes_and_libraries(cmd, _parser);
 
-		cmd += " -o \"" + _binary.string() + "\"";
-		cmd = "\"" + cmd + "\"";
+		cmd.insert(cmd.end(), { "-o", _binary.string() });
 
-		if (_print_cmds) CBUILD_TRACE(cmd);
-		if (system(cmd.c_str()) != 0) {
+		if (_print_cmds) CBUILD_TRACE(Process::args_to_string(cmd));
+		if (!Process::run(cmd, _result)) {
 
 			CBUILD_ERROR("Error occurred while linking binary.");
 			return false;
@@ -414,10 +505,10 @@ namespace CBuild {
 
 		if (_parser.run_binary) {
 
-			cmd = "cd " + _parser.get_build_output_path(_config).string() + " && \"" + _parser.build_name + "\"";
+			std::string run_cmd = "cd " + _parser.get_build_output_path(_config).string() + " && \"" + _parser.build_name + "\"";
 
-			if (_print_cmds) CBUILD_TRACE(cmd);
-			system(cmd.c_str());
+			if (_print_cmds) CBUILD_TRACE(run_cmd);
+			system(run_cmd.c_str());
 
 		}
 
@@ -425,23 +516,21 @@ namespace CBuild {
 
 	}
 
-	bool Compiler_Spec_Clang::build_static_lib(const std::filesystem::path _lib, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser) {
+	bool Compiler_Spec_Clang::build_static_lib(const std::filesystem::path _lib, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser, Process_Result& _result) {
 
-		std::string cmd = init_cmd(archiver_name, _parser);
-		cmd += " rcs \"" + _lib.string() + "\"";
+		std::vector<std::string> cmd = init_cmd(archiver_name, _parser);
+		cmd.insert(cmd.end(), { "rcs", _lib.string() });
 
 		for (const std::filesystem::path& file : _obj_files) {
 
 			if (File::file_exists(file)) {
-				cmd += " \"" + file.string() + "\"";
+				cmd.push_back(file.string());
 			}
 
 		}
 
-		cmd = "\"" + cmd + "\"";
-
-		if (_print_cmds) CBUILD_TRACE(cmd);
-		if (system(cmd.c_str()) != 0) {
+		if (_print_cmds) CBUILD_TRACE(Process::args_to_string(cmd));
+		if (!Process::run(cmd, _result)) {
 
 			CBUILD_ERROR("Error occurred while linking static library.");
 			return false;
@@ -6,6 +6,8 @@
 
 #include "types.h"
 #include "config.h"
+#include "process.h"
+#include "preprocessor.h"
 
 namespace CBuild {
 
@@ -28,14 +30,18 @@ namespace CBuild {
 
 		Compiler_Spec(Compiler_Type _type, const std::string _name, const std::string _archiver_name);
 		
-		virtual void add_common_flags(std::string& _cmd, const Config_Type _config, Parser& _parser) = 0;
-		virtual std::string build_source_cmd(const std::filesystem::path _source, const Config_Type _config, Parser& _parser) = 0;
-		virtual std::string build_pch_cmd(const std::filesystem::path _pch, const Config_Type _config, Parser& _parser) = 0;
-		virtual bool build_binary(const std::filesystem::path _binary, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser) = 0;
-		virtual bool build_static_lib(const std::filesystem::path _lib, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser) = 0;
+		virtual void add_common_flags(std::vector<std::string>& _cmd, const Config_Type _config, Parser& _parser) = 0;
+		virtual std::vector<std::string> build_source_cmd(const std::filesystem::path _source, const Config_Type _config, Parser& _parser) = 0;
+		virtual std::vector<std::string> build_pch_cmd(const std::filesystem::path _pch, const Config_Type _config, Parser& _parser) = 0;
+		virtual bool build_binary(const std::filesystem::path _binary, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser, Process_Result& _result) = 0;
+		virtual bool build_static_lib(const std::filesystem::path _lib, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser, Process_Result& _result) = 0;
+		virtual void add_predefined_macros(Preprocessor& _preprocessor, const Config_Type _config, Parser& _parser);
 
-		std::string init_cmd(const std::string& _name, Parser& _parser);
-		void add_includes_and_libraries(std::string& _cmd, Parser& _parser);
+		std::vector<std::string> init_cmd(const std::string& _name, Parser& _parser);
+		std::filesystem::path get_dep_path(const std::filesystem::path _source, const Config_Type _config, Parser& _parser);
+		void add_includes_and_libraries(std::vector<std::string>& _cmd, Parser& _parser);
+
+		static u64 hash_cmd(const std::vector<std::string>& _cmd);
 
 	};
 
@@ -43,11 +49,12 @@ namespace CBuild {
 
 		Compiler_Spec_GCC();
 
-		void add_common_flags(std::string& _cmd, const Config_Type _config, Parser& _parser) override;
-		std::string build_source_cmd(const std::filesystem::path _source, const Config_Type _config, Parser& _parser) override;
-		std::string build_pch_cmd(const std::filesystem::path _pch, const Config_Type _config, Parser& _parser) override;
-		bool build_binary(const std::filesystem::path _binary, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser) override;
-		bool build_static_lib(const std::filesystem::path _lib, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser) override;
+		void add_common_flags(std::vector<std::string>& _cmd, const Config_Type _config, Parser& _parser) override;
+		std::vector<std::string> build_source_cmd(const std::filesystem::path _source, const Config_Type _config, Parser& _parser) override;
+		std::vector<std::string> build_pch_cmd(const std::filesystem::path _pch, const Config_Type _config, Parser& _parser) override;
+		bool build_binary(const std::filesystem::path _binary, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser, Process_Result& _result) override;
+		bool build_static_lib(const std::filesystem::path _lib, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser, Process_Result& _result) override;
+		void add_predefined_macros(Preprocessor& _preprocessor, const Config_Type _config, Parser& _parser) override;
 
 	};
 
@@ -55,11 +62,12 @@ namespace CBuild {
 
 		Compiler_Spec_AVR_GCC();
 		
-		void add_common_flags(std::string& _cmd, const Config_Type _config, Parser& _parser) override;
-		std::string build_source_cmd(const std::filesystem::path _source, const Config_Type _config, Parser& _parser) override;
-		std::string build_pch_cmd(const std::filesystem::path _pch, const Config_Type _config, Parser& _parser) override;
-		bool build_binary(const std::filesystem::path _binary, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser) override;
-		bool build_static_lib(const std::filesystem::path _lib, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser) override;
+		void add_common_flags(std::vector<std::string>& _cmd, const Config_Type _config, Parser& _parser) override;
+		std::vector<std::string> build_source_cmd(const std::filesystem::path _source, const Config_Type _config, Parser& _parser) override;
+		std::vector<std::string> build_pch_cmd(const std::filesystem::path _pch, const Config_Type _config, Parser& _parser) override;
+		bool build_binary(const std::filesystem::path _binary, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser, Process_Result& _result) override;
+		bool build_static_lib(const std::filesystem::path _lib, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser, Process_Result& _result) override;
+		void add_predefined_macros(Preprocessor& _preprocessor, const Config_Type _config, Parser& _parser) override;
 
 	};
 
@@ -67,11 +75,12 @@ namespace CBuild {
 
 		Compiler_Spec_Clang();
 
-		void add_common_flags(std::string& _cmd, const Config_Type _config, Parser& _parser) override;
-		std::string build_source_cmd(const std::filesystem::path _source, const Config_Type _config, Parser& _parser) override;
-		std::string build_pch_cmd(const std::filesystem::path _pch, const Config_Type _config, Parser& _parser) override;
-		bool build_binary(const std::filesystem::path _binary, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser) override;
-		bool build_static_lib(const std::filesystem::path _lib, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser) override;
+		void add_common_flags(std::vector<std::string>& _cmd, const Config_Type _config, Parser& _parser) override;
+		std::vector<std::string> build_source_cmd(const std::filesystem::path _source, const Config_Type _config, Parser& _parser) override;
+		std::vector<std::string> build_pch_cmd(const std::filesystem::path _pch, const Config_Type _config, Parser& _parser) override;
+		bool build_binary(const std::filesystem::path _binary, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser, Process_Result& _result) override;
+		bool build_static_lib(const std::filesystem::path _lib, std::vector<std::filesystem::path>& _obj_files, const Config_Type _config, bool _print_cmds, Parser& _parser, Process_Result& _result) override;
+		void add_predefined_macros(Preprocessor& _preprocessor, const Config_Type _config, Parser& _parser) override;
 
 	};
 
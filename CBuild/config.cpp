@@ -1,8 +1,32 @@
 #include "pch.h"
 #include "config.h"
 
+#include <unordered_set>
+
 namespace CBuild {
 
+	static std::string escape_string(const std::string& _str) {
+
+		std::string result = "\"";
+
+		//Line breaks are escaped too, every entry has to stay on its own line.
+		for (char c : _str) {
+
+			if (c == '\n') result += "\\n";
+			else if (c == '\r') result += "\\r";
+			else {
+
+				if (c == '"' || c == '\\') result += '\\';
+				result += c;
+
+			}
+
+		}
+
+		return result + "\"";
+
+	}
+
 	Config_Type Config::string_to_config_type(std::string _config_name) {
 
 		String_Helper::lower(_config_name);
@@ -32,7 +56,7 @@ namespace CBuild {
 
 	}
 
-	void Config::set_config_timestamp(Config_Type _type, const std::filesystem::path& _path, u64 _time) {
+	void Config::set_config_timestamp(Config_Type _type, const std::filesystem::path& _path, u64 _time, u64 _hash, u64 _size) {
 
 		Config_Timestamps* timestamps = get_config_timestamps(_type);
 		if (timestamps == nullptr) {
@@ -47,12 +71,496 @@ namespace CBuild {
 
 		timestamps->timestamps[_path.string()] = _time;
 
+		if (_hash != 0) {
+
+			timestamps->hashes[_path.string()] = _hash;
+			timestamps->sizes[_path.string()] = _size;
+
+		}
+		else {
+
+			timestamps->hashes.erase(_path.string());
+			timestamps->sizes.erase(_path.string());
+
+		}
+
+	}
+
+	bool Config::get_config_content(Config_Type _type, const std::filesystem::path& _path, u64& _hash, u64& _size) {
+
+		_hash = 0;
+		_size = 0;
+
+		Config_Timestamps* timestamps = get_config_timestamps(_type);
+		if (timestamps == nullptr) return false;
+
+		const auto& it = timestamps->hashes.find(_path.string());
+		if (it == timestamps->hashes.end()) return false;
+
+		_hash = it->second;
+
+		const auto& size_it = timestamps->sizes.find(_path.string());
+		if (size_it != timestamps->sizes.end()) _size = size_it->second;
+
+		return true;
+
+	}
+
+	const std::vector<std::string>* Config::get_config_dependencies(Config_Type _type, const std::filesystem::path& _path) {
+
+		Config_Timestamps* timestamps = get_config_timestamps(_type);
+		if (timestamps == nullptr) return nullptr;
+
+		const auto& it = timestamps->dependencies.find(_path.string());
+		if (it == timestamps->dependencies.end()) return nullptr;
+
+		return &it->second;
+
+	}
+
+	void Config::set_config_dependencies(Config_Type _type, const std::filesystem::path& _path, const std::vector<std::filesystem::path>& _deps) {
+
+		Config_Timestamps* timestamps = get_config_timestamps(_type);
+		if (timestamps == nullptr) {
+
+			Config_Timestamps t;
+			t.type = _type;
+
+			configs[_type] = t;
+			timestamps = get_config_timestamps(_type);
+
+		}
+
+		std::vector<std::string>& deps = timestamps->dependencies[_path.string()];
+		deps.clear();
+
+		for (const std::filesystem::path& dep : _deps) {
+			deps.push_back(dep.string());
+		}
+
+		timestamps->dependents_indexed = false;
+
+	}
+
+	const std::vector<std::string>* Config::get_config_dependents(Config_Type _type, const std::filesystem::path& _path) {
+
+		Config_Timestamps* timestamps = get_config_timestamps(_type);
+		if (timestamps == nullptr) return nullptr;
+
+		index_dependents(*timestamps);
+
+		const auto& it = timestamps->dependents.find(_path.string());
+		if (it == timestamps->dependents.end()) return nullptr;
+
+		return &it->second;
+
+	}
+
+	void Config::index_dependents(Config_Timestamps& _timestamps) {
+
+		if (_timestamps.dependents_indexed) return;
+
+		//Depfiles list every header a source reads, so one reverse edge leads straight to each affected source.
+		_timestamps.dependents.clear();
+
+		for (const auto& deps_it : _timestamps.dependencies) {
+
+			for (const std::string& dep : deps_it.second) {
+
+				//A depfile can list a header more than once, when it's included more than once.
+				std::vector<std::string>& dependents = _timestamps.dependents[dep];
+				if (dependents.empty() || dependents.back() != deps_it.first) dependents.push_back(deps_it.first);
+
+			}
+
+		}
+
+		_timestamps.dependents_indexed = true;
+
+	}
+
+	bool Config::get_config_command(Config_Type _type, const std::filesystem::path& _path, u64& _hash) {
+
+		_hash = 0;
+
+		Config_Timestamps* timestamps = get_config_timestamps(_type);
+		if (timestamps == nullptr) return false;
+
+		const auto& it = timestamps->commands.find(_path.string());
+		if (it == timestamps->commands.end()) return false;
+
+		_hash = it->second;
+		return true;
+
+	}
+
+	void Config::set_config_command(Config_Type _type, const std::filesystem::path& _path, u64 _hash) {
+
+		Config_Timestamps* timestamps = get_config_timestamps(_type);
+		if (timestamps == nullptr) {
+
+			Config_Timestamps t;
+			t.type = _type;
+
+			configs[_type] = t;
+			timestamps = get_config_timestamps(_type);
+
+		}
+
+		timestamps->commands[_path.string()] = _hash;
+
+	}
+
+	void Config::prune_config_commands(Config_Type _type, const std::vector<std::filesystem::path>& _files) {
+
+		Config_Timestamps* timestamps = get_config_timestamps(_type);
+		if (timestamps == nullptr) return;
+
+		std::unordered_set<std::string> files;
+
+		for (const std::filesystem::path& file : _files) {
+			files.insert(file.string());
+		}
+
+		for (auto it = timestamps->commands.begin(); it != timestamps->commands.end();) {
+
+			if (files.find(it->first) == files.end()) it = timestamps->commands.erase(it);
+			else ++it;
+
+		}
+
+	}
+
+	const Include_Cache_Entry* Config::get_include_cache(const std::filesystem::path& _path, u64 _time, u64 _size) {
+
+		const auto& it = include_cache.find(_path.string());
+		if (it == include_cache.end()) return nullptr;
+
+		//The cached directives are only valid for the exact file that was scanned.
+		if (it->second.time != _time || it->second.size != _size) return nullptr;
+
+		return &it->second;
+
+	}
+
+	void Config::set_include_cache(const std::filesystem::path& _path, u64 _time, u64 _size, const std::vector<Directive>& _directives, const std::string& _guard) {
+		include_cache[_path.string()] = { _time, _size, _directives, _guard };
+	}
+
+	const Include_Cache_Entry* Config::get_include_cache(const std::filesystem::path& _path) {
+
+		//Headers in external include dirs are trusted without checking their timestamp.
+		const auto& it = include_cache.find(_path.string());
+		return (it != include_cache.end()) ? &it->second : nullptr;
+
+	}
+
+	void Config::remove_include_cache(const std::filesystem::path& _path) {
+		include_cache.erase(_path.string());
+	}
+
+	bool Config::parse_include_cache_line(const std::string& _line) {
+
+		//Format: "file" time size #guard "NAME" "local_include" <system_include> #include "MACRO" #define NAME "value" #if "expression" #endif ...
+		u64 length = _line.length();
+		u64 i = 0;
+
+		auto skip_spaces = [&]() {
+			while (i < length && isspace(_line[i])) ++i;
+		};
+
+		auto read_until = [&](char _end, std::string& _result) {
+
+			u64 start = ++i;
+			while (i < length && _line[i] != _end) ++i;
+
+			if (i >= length) return false;
+
+			_result = _line.substr(start, i - start);
+			++i;
+
+			return true;
+
+		};
+
+		auto read_string = [&](std::string& _result) {
+
+			//Macro values and expressions can contain quotes, so these are escaped.
+			if (i >= length || _line[i] != '"') return false;
+
+			_result.clear();
+
+			for (++i; i < length && _line[i] != '"'; ++i) {
+
+				if (_line[i] == '\\' && i + 1 < length) {
+
+					++i;
+					_result += (_line[i] == 'n') ? '\n' : (_line[i] == 'r') ? '\r' : _line[i];
+
+					continue;
+
+				}
+
+				_result += _line[i];
+
+			}
+
+			if (i >= length) return false;
+
+			++i;
+			return true;
+
+		};
+
+		auto read_word = [&](std::string& _result) {
+
+			u64 start = i;
+			while (i < length && !isspace(_line[i])) ++i;
+
+			_result = _line.substr(start, i - start);
+			return !_result.empty();
+
+		};
+
+		auto read_number = [&](u64& _result) {
+
+			u64 start = i;
+			while (i < length && _line[i] >= '0' && _line[i] <= '9') ++i;
+
+			if (i == start) return false;
+
+			std::stringstream stream(_line.substr(start, i - start));
+			stream >> _result;
+
+			return true;
+
+		};
+
+		std::string file;
+		Include_Cache_Entry entry;
+		bool has_guard = false;
+
+		skip_spaces();
+		if (i >= length || _line[i] != '"' || !read_until('"', file)) return false;
+
+		skip_spaces();
+		if (!read_number(entry.time)) return false;
+
+		skip_spaces();
+		if (!read_number(entry.size)) return false;
+
+		while (true) {
+
+			skip_spaces();
+			if (i >= length) break;
+
+			Directive directive;
+
+			if (_line[i] == '"' || _line[i] == '<') {
+
+				directive.angled = (_line[i] == '<');
+				if (!read_until(directive.angled ? '>' : '"', directive.name)) return false;
+
+				entry.directives.push_back(directive);
+				continue;
+
+			}
+
+			std::string type;
+			if (!read_word(type)) return false;
+
+			if (type == "#guard") {
+
+				skip_spaces();
+				if (!read_string(entry.guard)) return false;
+
+				has_guard = true;
+				continue;
+
+			}
+
+			if (type == "#include") directive.computed = true;
+			else if (type == "#if") directive.type = Directive_Type::If;
+			else if (type == "#ifdef") directive.type = Directive_Type::Ifdef;
+			else if (type == "#ifndef") directive.type = Directive_Type::Ifndef;
+			else if (type == "#elif") directive.type = Directive_Type::Elif;
+			else if (type == "#else") directive.type = Directive_Type::Else;
+			else if (type == "#endif") directive.type = Directive_Type::Endif;
+			else if (type == "#define") directive.type = Directive_Type::Define;
+			else if (type == "#undef") directive.type = Directive_Type::Undef;
+			else if (type == "#pragma_once") directive.type = Directive_Type::Pragma_Once;
+			else return false;
+
+			if (directive.type == Directive_Type::Define) {
+
+				skip_spaces();
+				if (!read_word(directive.name)) return false;
+
+				if (directive.name.length() > 2 && directive.name.compare(directive.name.length() - 2, 2, "()") == 0) {
+
+					directive.name.erase(directive.name.length() - 2);
+					directive.function_like = true;
+
+				}
+
+				skip_spaces();
+				if (!read_string(directive.value)) return false;
+
+			}
+			else if (directive.type != Directive_Type::Else && directive.type != Directive_Type::Endif && directive.type != Directive_Type::Pragma_Once) {
+
+				skip_spaces();
+				if (!read_string(directive.name)) return false;
+
+			}
+
+			entry.directives.push_back(directive);
+
+		}
+
+		//Lines written before guards were recorded.
+		if (!has_guard) entry.guard = Include_Scanner::find_guard(entry.directives);
+
+		std::filesystem::path path = std::filesystem::u8path(file);
+		File::format_path(path);
+
+		include_cache[path.string()] = entry;
+
+		return true;
+
+	}
+
+	bool Config::parse_external_line(const std::string& _line) {
+
+		//Format: "dir" fingerprint "sub_dir" ...
+		size_t start = _line.find('"');
+		size_t end = (start != std::string::npos) ? _line.find('"', start + 1) : std::string::npos;
+
+		if (end == std::string::npos) return false;
+
+		std::stringstream stream(_line.substr(end + 1));
+		u64 fingerprint = 0;
+
+		if (!(stream >> fingerprint)) return false;
+
+		std::filesystem::path path = std::filesystem::u8path(_line.substr(start + 1, end - start - 1));
+		File::format_path(path);
+
+		external_fingerprints[path.string()] = fingerprint;
+
+		std::vector<std::string>& subdirs = external_subdirs[path.string()];
+		subdirs.clear();
+
+		while ((start = _line.find('"', end + 1)) != std::string::npos && (end = _line.find('"', start + 1)) != std::string::npos) {
+			subdirs.push_back(_line.substr(start + 1, end - start - 1));
+		}
+
+		return true;
+
+	}
+
+	bool Config::parse_command_line(const std::string& _line) {
+
+		//Format: config_type "file" digest
+		size_t start = _line.find('"');
+		size_t end = (start != std::string::npos) ? _line.find('"', start + 1) : std::string::npos;
+
+		if (end == std::string::npos) return false;
+
+		std::string type_name = _line.substr(0, start);
+		String_Helper::trim(type_name);
+
+		Config_Type type = string_to_config_type(type_name);
+		if (type == Config_Type::Invalid) return false;
+
+		std::stringstream stream(_line.substr(end + 1));
+		u64 hash = 0;
+
+		if (!(stream >> hash)) return false;
+
+		//Entries of sources that are gone are pruned by the build, so loading doesn't touch the filesystem.
+		std::filesystem::path path = std::filesystem::u8path(_line.substr(start + 1, end - start - 1));
+		File::format_path(path);
+
+		set_config_command(type, path, hash);
+
+		return true;
+
+	}
+
+	bool Config::parse_listing_line(const std::string& _line) {
+
+		//Format: "dir" time "sub_dir/" "file" ...
+		u64 length = _line.length();
+		u64 i = 0;
+
+		std::string dir;
+		Dir_Listing listing;
+
+		auto read_string = [&](std::string& _result) {
+
+			while (i < length && isspace(_line[i])) ++i;
+			if (i >= length || _line[i] != '"') return false;
+
+			_result.clear();
+
+			for (++i; i < length && _line[i] != '"'; ++i) {
+
+				if (_line[i] == '\\' && i + 1 < length) {
+
+					++i;
+					_result += (_line[i] == 'n') ? '\n' : (_line[i] == 'r') ? '\r' : _line[i];
+
+					continue;
+
+				}
+
+				_result += _line[i];
+
+			}
+
+			if (i >= length) return false;
+
+			++i;
+			return true;
+
+		};
+
+		if (!read_string(dir)) return false;
+
+		while (i < length && isspace(_line[i])) ++i;
+
+		u64 start = i;
+		while (i < length && _line[i] >= '0' && _line[i] <= '9') ++i;
+
+		if (i == start) return false;
+
+		std::stringstream stream(_line.substr(start, i - start));
+		stream >> listing.time;
+
+		std::string name;
+
+		while (read_string(name)) {
+
+			if (!name.empty() && name.back() == '/') listing.dirs.push_back(name.substr(0, name.length() - 1));
+			else listing.files.push_back(name);
+
+		}
+
+		dir_listings[dir] = listing;
+
+		return true;
+
 	}
 
 	void Config::clear_config() {
 
 		last_used_type = Config_Type::Invalid;
 		configs.clear();
+		include_cache.clear();
+		external_fingerprints.clear();
+		external_subdirs.clear();
+		dir_listings.clear();
 
 	}
 
@@ -71,6 +579,11 @@ namespace CBuild {
 
 		Config_Type config_type = Config_Type::Invalid;
 		std::filesystem::path timestamp_path;
+		u64 timestamp_time = 0;
+		u64 timestamp_hash = 0;
+
+		std::filesystem::path deps_path;
+		std::vector<std::filesystem::path> deps;
 
 		for (const char& c : source) {
 
@@ -94,6 +607,25 @@ namespace CBuild {
 
 					}
 
+					if (token == "deps") {
+
+						token = "";
+						state = 5;
+
+						continue;
+
+					}
+
+					if (token == "directives" || token == "external" || token == "listing" || token == "command") {
+
+						cmd = token;
+						token = "";
+						state = 7;
+
+						continue;
+
+					}
+
 					Config_Type t = string_to_config_type(token);
 					if (t == Config_Type::Invalid) {
 
@@ -172,23 +704,37 @@ namespace CBuild {
 
 			}
 
-			//Timestamp.
-			else if (state == 2) {
+			//Timestamp, optionally followed by a content digest and the file size.
+			else if (state == 2 || state == 8 || state == 9) {
 
 				if (c == '\n' || (isspace(c) && !token.empty())) {
 
 					if (!token.empty()) {
 
 						std::stringstream stream(token);
-						u64 time;
-						stream >> time;
+						u64 value;
+						stream >> value;
+
+						if (state == 2) {
+
+							timestamp_time = value;
+							set_config_timestamp(config_type, timestamp_path, value);
+
+						}
+						else if (state == 8) {
 
-						set_config_timestamp(config_type, timestamp_path, time);
+							timestamp_hash = value;
+							set_config_timestamp(config_type, timestamp_path, timestamp_time, value);
+
+						}
+						else {
+							set_config_timestamp(config_type, timestamp_path, timestamp_time, timestamp_hash, value);
+						}
 
 					}
 
 					token = "";
-					state = (c == '\n') ? 0 : 4;
+					state = (c == '\n') ? 0 : (state == 2) ? 8 : (state == 8) ? 9 : 4;
 
 				}
 				else if (isspace(c)) {
@@ -237,6 +783,100 @@ namespace CBuild {
 
 			}
 
+			//Dependency config type.
+			else if (state == 5) {
+
+				if (c == '\n') {
+
+					token = "";
+					state = 0;
+
+				}
+				else if (isspace(c)) {
+
+					if (token.empty()) continue;
+
+					config_type = string_to_config_type(token);
+
+					deps_path.clear();
+					deps.clear();
+
+					token = "";
+					string_state = 0;
+					state = (config_type != Config_Type::Invalid) ? 6 : 4;
+
+				}
+				else {
+					token += c;
+				}
+
+			}
+
+			//Dependencies, the first string is the source file.
+			else if (state == 6) {
+
+				if (c == '\n') {
+
+					if (string_state == 0 && !deps_path.empty() && File::file_exists(deps_path)) {
+						set_config_dependencies(config_type, deps_path, deps);
+					}
+
+					token = "";
+					state = 0;
+
+				}
+				else if (c == '"') {
+
+					if (string_state == 0) {
+
+						string_state = 1;
+						continue;
+
+					}
+
+					string_state = 0;
+
+					std::filesystem::path path = std::filesystem::u8path(token);
+					File::format_path(path);
+
+					if (deps_path.empty()) deps_path = path;
+					else deps.push_back(path);
+
+					token = "";
+
+				}
+				else if (string_state == 1) {
+					token += c;
+				}
+				else if (!isspace(c)) {
+
+					token = "";
+					state = 4;
+
+				}
+
+			}
+
+			//Cached preprocessor directives, external include dir fingerprints, directory listings and command digests, parsed once the whole line has been read.
+			else if (state == 7) {
+
+				if (c == '\n') {
+
+					if (cmd == "directives") parse_include_cache_line(token);
+					else if (cmd == "listing") parse_listing_line(token);
+					else if (cmd == "command") parse_command_line(token);
+					else parse_external_line(token);
+
+					token = "";
+					state = 0;
+
+				}
+				else {
+					token += c;
+				}
+
+			}
+
 			//Wait for new line.
 			else if (state == 4) {
 
@@ -265,16 +905,37 @@ namespace CBuild {
 		auto config_it = configs.begin();
 		while (config_it != configs.end()) {
 
-			Config_Timestamps t = config_it->second;
+			Config_Timestamps& t = config_it->second;
 
 			auto timestamp_it = t.timestamps.begin();
 			while (timestamp_it != t.timestamps.end()) {
 
-				source += config_type_to_string(config_it->first) + " \"" + timestamp_it->first + "\" " + std::to_string(timestamp_it->second) + "\n";
+				source += config_type_to_string(config_it->first) + " \"" + timestamp_it->first + "\" " + std::to_string(timestamp_it->second);
+
+				const auto& hash_it = t.hashes.find(timestamp_it->first);
+				if (hash_it != t.hashes.end()) source += " " + std::to_string(hash_it->second) + " " + std::to_string(t.sizes[timestamp_it->first]);
+
+				source += "\n";
 				++timestamp_it;
 
 			}
 
+			for (const auto& deps_it : t.dependencies) {
+
+				source += "deps " + config_type_to_string(config_it->first) + " \"" + deps_it.first + "\"";
+
+				for (const std::string& dep : deps_it.second) {
+					source += " \"" + dep + "\"";
+				}
+
+				source += "\n";
+
+			}
+
+			for (const auto& command_it : t.commands) {
+				source += "command " + config_type_to_string(config_it->first) + " \"" + command_it.first + "\" " + std::to_string(command_it.second) + "\n";
+			}
+
 			if(config_ind < config_count - 1) source += "\n";
 
 			++config_ind;
@@ -282,6 +943,72 @@ namespace CBuild {
 
 		}
 
+		if (external_fingerprints.size() > 0) source += "\n";
+
+		for (const auto& external_it : external_fingerprints) {
+			source += "external \"" + external_it.first + "\" " + std::to_string(external_it.second);
+
+			const auto& subdirs_it = external_subdirs.find(external_it.first);
+
+			if (subdirs_it != external_subdirs.end()) {
+
+				for (const std::string& subdir : subdirs_it->second) {
+					source += " \"" + subdir + "\"";
+				}
+
+			}
+
+			source += "\n";
+		}
+
+		if (dir_listings.size() > 0) source += "\n";
+
+		for (const auto& listing_it : dir_listings) {
+
+			source += "listing " + escape_string(listing_it.first) + " " + std::to_string(listing_it.second.time);
+
+			for (const std::string& dir : listing_it.second.dirs) {
+				source += " " + escape_string(dir + "/");
+			}
+
+			for (const std::string& file : listing_it.second.files) {
+				source += " " + escape_string(file);
+			}
+
+			source += "\n";
+
+		}
+
+		if (include_cache.size() > 0) source += "\n";
+
+		for (const auto& cache_it : include_cache) {
+
+			source += "directives \"" + cache_it.first + "\" " + std::to_string(cache_it.second.time) + " " + std::to_string(cache_it.second.size);
+			if (!cache_it.second.guard.empty()) source += " #guard " + escape_string(cache_it.second.guard);
+
+			for (const Directive& directive : cache_it.second.directives) {
+
+				switch (directive.type) {
+
+					case Directive_Type::Include: source += directive.computed ? " #include " + escape_string(directive.name) : directive.angled ? " <" + directive.name + ">" : " \"" + directive.name + "\""; break;
+					case Directive_Type::Define: source += " #define " + directive.name + (directive.function_like ? "() " : " ") + escape_string(directive.value); break;
+					case Directive_Type::Undef: source += " #undef " + escape_string(directive.name); break;
+					case Directive_Type::If: source += " #if " + escape_string(directive.name); break;
+					case Directive_Type::Ifdef: source += " #ifdef " + escape_string(directive.name); break;
+					case Directive_Type::Ifndef: source += " #ifndef " + escape_string(directive.name); break;
+					case Directive_Type::Elif: source += " #elif " + escape_string(directive.name); break;
+					case Directive_Type::Else: source += " #else"; break;
+					case Directive_Type::Endif: source += " #endif"; break;
+					case Directive_Type::Pragma_Once: source += " #pragma_once"; break;
+
+				}
+
+			}
+
+			source += "\n";
+
+		}
+
 		return File::write_text_file(_path, source);
 
 	}
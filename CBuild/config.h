@@ -3,10 +3,12 @@
 #include <filesystem>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "types.h"
 #include "file.h"
 #include "string_helper.h"
+#include "include_scanner.h"
 
 namespace CBuild {
 
@@ -22,6 +24,29 @@ namespace CBuild {
 
 		Config_Type type = Config_Type::Invalid;
 		std::unordered_map<std::string, u64> timestamps;
+		std::unordered_map<std::string, u64> hashes; //Content digests, only recomputed when the timestamp or size differs.
+		std::unordered_map<std::string, u64> sizes;
+		std::unordered_map<std::string, std::vector<std::string>> dependencies;
+		std::unordered_map<std::string, std::vector<std::string>> dependents; //Reverse of the dependencies, from each file to the sources that include it.
+		bool dependents_indexed = false; //The reverse index is rebuilt from the dependencies the first time it's needed after they change.
+		std::unordered_map<std::string, u64> commands; //Digest of the command each object and the PCH were last compiled with.
+
+	};
+
+	struct Include_Cache_Entry {
+
+		u64 time = 0;
+		u64 size = 0;
+		std::vector<Directive> directives;
+		std::string guard = ""; //Include guard macro, empty if the file isn't guarded.
+
+	};
+
+	struct Dir_Listing {
+
+		u64 time = 0; //Modification time of the directory, which changes whenever an entry is added, removed or renamed.
+		std::vector<std::string> dirs;
+		std::vector<std::string> files;
 
 	};
 
@@ -30,12 +55,32 @@ namespace CBuild {
 		Config_Type last_used_type = Config_Type::Invalid;
 		std::string last_used_compiler = "gcc";
 		std::unordered_map<Config_Type, Config_Timestamps> configs;
+		std::unordered_map<std::string, Include_Cache_Entry> include_cache;
+		std::unordered_map<std::string, u64> external_fingerprints;
+		std::unordered_map<std::string, std::vector<std::string>> external_subdirs; //Directories below each external include dir that headers were found in.
+		std::unordered_map<std::string, Dir_Listing> dir_listings;
 
 		Config_Type string_to_config_type(std::string _config_name);
 		std::string config_type_to_string(Config_Type _type);
 		
 		Config_Timestamps* get_config_timestamps(Config_Type _type);
-		void set_config_timestamp(Config_Type _type, const std::filesystem::path& _path, u64 _time);
+		void set_config_timestamp(Config_Type _type, const std::filesystem::path& _path, u64 _time, u64 _hash = 0, u64 _size = 0);
+		bool get_config_content(Config_Type _type, const std::filesystem::path& _path, u64& _hash, u64& _size);
+		const std::vector<std::string>* get_config_dependencies(Config_Type _type, const std::filesystem::path& _path);
+		void set_config_dependencies(Config_Type _type, const std::filesystem::path& _path, const std::vector<std::filesystem::path>& _deps);
+		const std::vector<std::string>* get_config_dependents(Config_Type _type, const std::filesystem::path& _path);
+		void index_dependents(Config_Timestamps& _timestamps);
+		bool get_config_command(Config_Type _type, const std::filesystem::path& _path, u64& _hash);
+		void set_config_command(Config_Type _type, const std::filesystem::path& _path, u64 _hash);
+		void prune_config_commands(Config_Type _type, const std::vector<std::filesystem::path>& _files);
+		const Include_Cache_Entry* get_include_cache(const std::filesystem::path& _path, u64 _time, u64 _size);
+		const Include_Cache_Entry* get_include_cache(const std::filesystem::path& _path);
+		void set_include_cache(const std::filesystem::path& _path, u64 _time, u64 _size, const std::vector<Directive>& _directives, const std::string& _guard);
+		void remove_include_cache(const std::filesystem::path& _path);
+		bool parse_include_cache_line(const std::string& _line);
+		bool parse_external_line(const std::string& _line);
+		bool parse_listing_line(const std::string& _line);
+		bool parse_command_line(const std::string& _line);
 		void clear_config();
 		bool load_config(std::filesystem::path _path);
 		bool save_config(std::filesystem::path _path);
@@ -0,0 +1,236 @@
+#include "pch.h"
+#include "content_hash.h"
+#include "hash.h"
+
+#include <algorithm>
+
+namespace CBuild {
+
+	static inline bool is_space(char _char) {
+		return (_char == ' ' || _char == '\t' || _char == '\r' || _char == '\v' || _char == '\f');
+	}
+
+	static inline bool is_identifier_char(char _char) {
+		return (_char == '_') || (_char >= '0' && _char <= '9') || (_char >= 'A' && _char <= 'Z') || (_char >= 'a' && _char <= 'z');
+	}
+
+	static inline size_t get_line_splice(const char* _data, size_t _index, size_t _length) {
+
+		if (_data[_index] != '\\') return 0;
+		if (_index + 1 < _length && _data[_index + 1] == '\n') return 2;
+		if (_index + 2 < _length && _data[_index + 1] == '\r' && _data[_index + 2] == '\n') return 3;
+
+		return 0;
+
+	}
+
+	static bool is_raw_string_prefix(const std::string& _stream) {
+
+		//R"...", LR"...", uR"...", UR"..." and u8R"..." where the prefix isn't the end of a longer identifier.
+		size_t length = _stream.length();
+		if (length <= 0 || _stream[length - 1] != 'R') return false;
+
+		size_t start = length - 1;
+
+		if (start >= 2 && _stream.compare(start - 2, 2, "u8") == 0) start -= 2;
+		else if (start >= 1 && (_stream[start - 1] == 'L' || _stream[start - 1] == 'u' || _stream[start - 1] == 'U')) start -= 1;
+
+		return start == 0 || !is_identifier_char(_stream[start - 1]);
+
+	}
+
+	static bool would_paste(char _prev, char _cur, bool _number) {
+
+		//Numbers swallow dots, digit separators and exponent signs, identifiers and literals take prefixes and suffixes.
+		if (_number && (is_identifier_char(_cur) || _cur == '.' || _cur == '\'' || _cur == '+' || _cur == '-')) return true;
+		if (is_identifier_char(_prev)) return is_identifier_char(_cur) || _cur == '"' || _cur == '\'';
+		if (_prev == '"' || _prev == '\'') return is_identifier_char(_cur);
+		if (_prev == '.' && _cur >= '0' && _cur <= '9') return true;
+
+		static const char* punctuators[] = { "++", "--", "->", "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=", "<<", ">>", "<=", ">=", "==", "!=", "&&", "||", "##", "::", "..", ".*", "<:", ":>", "<%", "%>", "%:", "//", "/*" };
+
+		for (const char* punctuator : punctuators) {
+			if (punctuator[0] == _prev && punctuator[1] == _cur) return true;
+		}
+
+		return false;
+
+	}
+
+	u64 Content_Hash::tokens(const std::string& _source) {
+
+		//Comments become whitespace, and whitespace only matters where two tokens would otherwise paste together
+		//or where a preprocessor directive ends, so reformatting or editing a comment gives the same hash
+		//while any change to the tokens the compiler sees doesn't.
+		const char* data = _source.data();
+		size_t length = _source.length();
+
+		std::string stream;
+		stream.reserve(length);
+
+		bool space = false;
+		bool line_start = true;
+		bool directive = false;
+		bool number = false; //The last token in the stream is a number.
+
+		size_t i = 0;
+
+		while (i < length) {
+
+			char cur = data[i];
+			char next = (i + 1 < length) ? data[i + 1] : '\0';
+
+			size_t splice = get_line_splice(data, i, length);
+
+			if (splice > 0) {
+
+				i += splice;
+				continue;
+
+			}
+
+			if (cur == '\n' || is_space(cur)) {
+
+				space = true;
+
+				if (cur == '\n') {
+
+					if (directive) stream += '\n';
+
+					line_start = true;
+					directive = false;
+
+				}
+
+				++i;
+				continue;
+
+			}
+
+			if (cur == '/' && next == '/') {
+
+				for (; i < length && data[i] != '\n'; ++i) {
+
+					splice = get_line_splice(data, i, length);
+					if (splice > 0) i += splice - 1;
+
+				}
+
+				continue;
+
+			}
+
+			if (cur == '/' && next == '*') {
+
+				size_t end = _source.find("*/", i + 2);
+				if (end == std::string::npos) end = length;
+
+				//A comment is a single space even when it spans lines, so it doesn't end a directive.
+				space = true;
+
+				i = std::min(end + 2, length);
+				continue;
+
+			}
+
+			if (line_start && cur == '#') {
+
+				//Directives are delimited on both ends, so their tokens can't be confused with the code around them.
+				if (!stream.empty() && stream.back() != '\n') stream += '\n';
+				directive = true;
+
+			}
+			else if (space && !stream.empty()) {
+
+				//In a directive, the space in '#define NAME (x)' is what makes it an object-like macro.
+				if (would_paste(stream.back(), cur, number) || (directive && cur == '(' && is_identifier_char(stream.back()))) stream += ' ';
+
+			}
+
+			space = false;
+			line_start = false;
+			number = false;
+
+			//Literals are kept as they are, raw strings can span lines and contain anything but their delimiter.
+			if (cur == '"' && is_raw_string_prefix(stream)) {
+
+				size_t open = _source.find('(', i);
+				size_t end = (open != std::string::npos) ? _source.find(")" + _source.substr(i + 1, open - i - 1) + "\"", open) : std::string::npos;
+
+				end = (end != std::string::npos) ? end + (open - i) + 1 : length;
+				stream.append(data + i, end - i);
+
+				i = end;
+				continue;
+
+			}
+
+			if (cur == '"' || cur == '\'') {
+
+				size_t start = i;
+
+				for (++i; i < length; ++i) {
+
+					if (data[i] == '\\') ++i;
+					else if (data[i] == cur || data[i] == '\n') break;
+
+				}
+
+				if (i < length && data[i] == cur) ++i;
+				i = std::min(i, length);
+
+				stream.append(data + start, i - start);
+				continue;
+
+			}
+
+			//Numbers are read whole, so a digit separator like 1'000 isn't mistaken for a character literal.
+			if (cur >= '0' && cur <= '9' && (stream.empty() || !is_identifier_char(stream.back()))) {
+
+				size_t start = i;
+
+				for (++i; i < length; ++i) {
+
+					char c = data[i];
+					char prev = data[i - 1];
+
+					if (is_identifier_char(c) || c == '.') continue;
+					if (c == '\'' && i + 1 < length && is_identifier_char(data[i + 1])) continue;
+					if ((c == '+' || c == '-') && (prev == 'e' || prev == 'E' || prev == 'p' || prev == 'P')) continue;
+
+					break;
+
+				}
+
+				stream.append(data + start, i - start);
+				number = true;
+
+				continue;
+
+			}
+
+			stream += cur;
+			++i;
+
+		}
+
+		return Hash::xxh64(stream.data(), stream.length());
+
+	}
+
+
+	u64 Content_Hash::digest(const std::string& _source, bool _tokens) {
+
+		//The lowest bit tells which kind of digest it is, so a stored one can still be compared after switching -hash_tokens.
+		u64 hash = _tokens ? tokens(_source) : Hash::xxh64(_source.data(), _source.length());
+		hash = (hash & ~1ull) | (_tokens ? 1 : 0);
+
+		return (hash != 0) ? hash : 2; //Zero means no digest.
+
+	}
+
+	bool Content_Hash::is_tokens(u64 _digest) {
+		return (_digest & 1) != 0;
+	}
+
+}
\ No newline at end of file
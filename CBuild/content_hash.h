@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+
+#include "types.h"
+
+namespace CBuild {
+
+	struct Content_Hash {
+
+		static u64 tokens(const std::string& _source);
+		static u64 digest(const std::string& _source, bool _tokens);
+		static bool is_tokens(u64 _digest);
+
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,1168 @@
+#include "pch.h"
+#include "dependency_scanner.h"
+#include "parser.h"
+#include "include_scanner.h"
+#include "depfile.h"
+#include "content_hash.h"
+
+#include <algorithm>
+#include <unordered_set>
+#include <set>
+
+namespace CBuild {
+
+	Dependency_Scanner::Dependency_Scanner(Parser& _parser, Config_Type _config_type, const std::string& _compiler, u32 _job_count) : parser(_parser), config_type(_config_type), compiler(_compiler), job_pool(_job_count) {
+
+		for (const std::filesystem::path& include_dir : parser.incl_dirs) {
+			incl_dir_ids.push_back(path_table.intern(include_dir));
+		}
+
+		const auto& spec_it = parser.compiler_specs.find(_compiler);
+		if (spec_it != parser.compiler_specs.end()) compiler_spec = spec_it->second;
+
+		if (compiler_spec != nullptr) compiler_spec->add_predefined_macros(predefined, _config_type, parser);
+
+		for (const std::filesystem::path& external_incl_dir : parser.external_incl_dirs) {
+
+			External_Dir& external_dir = external_dirs.emplace_back();
+			external_dir.path = Path_Table::canonicalize(external_incl_dir);
+			external_dir.prefix = (external_dir.path / "").string();
+
+			const auto& subdirs_it = parser.config.external_subdirs.find(external_dir.path.string());
+			if (subdirs_it != parser.config.external_subdirs.end()) external_dir.subdirs = subdirs_it->second;
+
+			external_dir.fingerprint = get_fingerprint(external_dir.path, external_dir.subdirs);
+
+			const auto& it = parser.config.external_fingerprints.find(external_dir.path.string());
+			external_dir.unchanged = (it != parser.config.external_fingerprints.end() && it->second == external_dir.fingerprint);
+
+		}
+
+	}
+
+	Dependency_Scanner::~Dependency_Scanner() {
+
+		//Scan jobs still reference the memo table, so let them finish before it is destroyed.
+		job_pool.wait();
+
+	}
+
+	void Dependency_Scanner::prefetch(const std::vector<std::filesystem::path>& _sources) {
+
+		//Every file the last build tracked is likely to be checked again, so stat them all up front in one batch
+		//instead of one blocking call at a time from the scan jobs.
+		std::vector<Path_ID> ids;
+		std::vector<std::filesystem::path> paths;
+
+		auto add_path = [this, &ids, &paths](const std::filesystem::path& _path) {
+
+			Path_ID id = path_table.intern(_path);
+			if (id < prefetched.size() && prefetched[id]) return;
+
+			if (prefetched.size() <= id) prefetched.resize((u64)id + 1, false);
+			prefetched[id] = true;
+
+			std::filesystem::path path = path_table.get_path(id);
+
+			//Files in unchanged external include dirs are never stat'ed.
+			const External_Dir* external = external_dirs.empty() ? nullptr : find_external_dir(path);
+			if (external != nullptr && external->unchanged) return;
+
+			ids.push_back(id);
+			paths.push_back(path);
+
+		};
+
+		for (const std::filesystem::path& source : _sources) {
+			add_path(source);
+		}
+
+		Config_Timestamps* timestamps = parser.config.get_config_timestamps(config_type);
+
+		if (timestamps != nullptr) {
+
+			for (const auto& it : timestamps->timestamps) {
+				add_path(std::filesystem::u8path(it.first));
+			}
+
+		}
+
+		std::vector<File_Info> infos;
+		stat_method = Stat_Batch::stat_all(paths, infos, job_pool);
+		prefetched_files = paths.size();
+
+		file_infos.resize(prefetched.size());
+
+		for (u64 i = 0; i < ids.size(); ++i) {
+			file_infos[ids[i]] = infos[i];
+		}
+
+	}
+
+	bool Dependency_Scanner::get_file_info(Path_ID _id, const std::filesystem::path& _path, File_Info& _info) {
+
+		if (_id < prefetched.size() && prefetched[_id]) {
+
+			_info = file_infos[_id];
+			return _info.exists;
+
+		}
+
+		return File::get_info(_path, _info);
+
+	}
+
+	bool Dependency_Scanner::find_affected_sources(const std::vector<std::filesystem::path>& _sources, std::vector<bool>& _affected) {
+
+		//Goes from the files that differ from the last build outward through the reverse dependency index,
+		//instead of walking the includes of every source. Expects the stats to have been prefetched.
+		Config_Timestamps* timestamps = parser.config.get_config_timestamps(config_type);
+		if (timestamps == nullptr) return false;
+
+		parser.config.index_dependents(*timestamps);
+
+		std::unordered_set<std::string> affected;
+
+		for (const auto& dependents_it : timestamps->dependents) {
+
+			if (!is_suspect(std::filesystem::u8path(dependents_it.first), *timestamps)) continue;
+
+			++suspect_files;
+			affected.insert(dependents_it.second.begin(), dependents_it.second.end());
+
+		}
+
+		std::filesystem::path obj_output_path = parser.get_obj_output_path(config_type);
+
+		_affected.assign(_sources.size(), true);
+
+		for (u64 i = 0; i < _sources.size(); ++i) {
+
+			const std::filesystem::path& source = _sources[i];
+
+			//Sources without dependencies from a depfile haven't been compiled yet, or their last compile failed.
+			if (affected.find(source.string()) != affected.end()) continue;
+			if (timestamps->dependencies.find(source.string()) == timestamps->dependencies.end()) continue;
+			if (is_suspect(source, *timestamps)) continue;
+
+			std::filesystem::path obj_file_path = parser.get_obj_path(source, config_type);
+
+			File_Info obj_info;
+			if (!File::get_info(obj_file_path, obj_info)) continue;
+
+			_affected[i] = false;
+
+		}
+
+		propagated = true;
+		total_sources = _sources.size();
+		affected_sources = (u64)std::count(_affected.begin(), _affected.end(), true);
+
+		return true;
+
+	}
+
+	bool Dependency_Scanner::is_suspect(const std::filesystem::path& _path, const Config_Timestamps& _timestamps) {
+
+		//A new timestamp or size only means the file might have changed, the scan decides with the digest.
+		Path_ID id = path_table.intern(_path);
+		std::filesystem::path path = path_table.get_path(id);
+
+		const External_Dir* external = external_dirs.empty() ? nullptr : find_external_dir(path);
+		if (external != nullptr) return !external->unchanged;
+
+		File_Info info;
+		if (!get_file_info(id, path, info) || info.is_directory) return true;
+
+		const auto& time_it = _timestamps.timestamps.find(path.string());
+		if (time_it == _timestamps.timestamps.end() || time_it->second != info.time) return true;
+
+		const auto& size_it = _timestamps.sizes.find(path.string());
+		if (size_it != _timestamps.sizes.end() && size_it->second != info.size) return true;
+
+		//Digests of the other kind are replaced, so a later edit can be compared with the right one.
+		const auto& hash_it = _timestamps.hashes.find(path.string());
+		return (hash_it != _timestamps.hashes.end() && Content_Hash::is_tokens(hash_it->second) != hash_tokens);
+
+	}
+
+	Path_ID Dependency_Scanner::add_file(const std::filesystem::path& _path, bool _scan) {
+
+		Path_ID id = path_table.intern(_path);
+		const External_Dir* external = external_dirs.empty() ? nullptr : find_external_dir(path_table.get_path(id));
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		Checked_File* file = get_file(id);
+
+		if (file->added) {
+
+			//A file first seen in a depfile still has to be scanned once something includes it directly.
+			if (!_scan || file->scanned) return id;
+
+		}
+		else {
+
+			file->added = true;
+			file->path = path_table.get_path(id);
+			file->external = external;
+
+		}
+
+		if (_scan) file->scanned = true;
+		++file->pending_jobs;
+
+		job_pool.submit("", [this, file, _scan]() {
+
+			scan_file(file, _scan);
+			return true;
+
+		});
+
+		return id;
+
+	}
+
+	Checked_File* Dependency_Scanner::get_file(Path_ID _id) {
+
+		//Expects the scanner mutex to be held, deque elements keep their address while it grows.
+		while (files.size() <= _id) {
+
+			Checked_File& file = files.emplace_back();
+			file.id = (Path_ID)(files.size() - 1);
+
+		}
+
+		return &files[_id];
+
+	}
+
+	void Dependency_Scanner::scan_file(Checked_File* _file, bool _scan) {
+
+		if (_file->external != nullptr && _file->external->unchanged) {
+
+			scan_external_file(_file, _scan);
+			return;
+
+		}
+
+		const std::filesystem::path& path = _file->path;
+
+		File_Info info;
+		bool exists = get_file_info(_file->id, path, info) && !info.is_directory;
+		bool changed = !_scan; //A dependency from a depfile that has been removed forces a rebuild.
+		bool touched = false;
+		u64 time = 0;
+		u64 size = 0;
+		u64 hash = 0;
+
+		std::string source;
+		bool read = false;
+
+		File_Includes includes;
+
+		if (!exists) {
+
+			if (_scan) {
+
+				std::lock_guard<std::mutex> lock(mutex);
+				parser.config.remove_include_cache(path);
+
+			}
+
+		}
+		else {
+
+			//Only a new timestamp or size means the file has to be hashed again, and only a new digest means it changed,
+			//so a checkout or cache restore that rewrites identical files doesn't rebuild anything.
+			time = info.time;
+			size = info.size;
+
+			bool time_changed = parser.has_timestamp_changed(path, config_type, time);
+
+			u64 stored_hash = 0;
+			u64 stored_size = 0;
+			parser.config.get_config_content(config_type, path, stored_hash, stored_size);
+
+			if (!time_changed && size == stored_size && stored_hash != 0 && Content_Hash::is_tokens(stored_hash) == hash_tokens) {
+
+				hash = stored_hash;
+				changed = false;
+
+			}
+			else if (!time_changed && size == stored_size && stored_hash != 0 && (read = File::read_text_file(path, source))) {
+
+				//Unchanged since its digest was taken with -hash_tokens the other way, so it's only hashed again.
+				hash = Content_Hash::digest(source, hash_tokens);
+				changed = false;
+				touched = true;
+
+			}
+			else if ((read = File::read_text_file(path, source))) {
+
+				//Token hashes ignore comments and whitespace, digests of the raw bytes don't.
+				hash = Content_Hash::digest(source, hash_tokens);
+
+				//A digest of the other kind is compared as that kind, so toggling -hash_tokens only re-hashes.
+				if (stored_hash != 0) {
+
+					u64 compared_hash = (Content_Hash::is_tokens(stored_hash) == hash_tokens) ? hash : Content_Hash::digest(source, !hash_tokens);
+					changed = (compared_hash != stored_hash);
+
+				}
+				else {
+					changed = time_changed;
+				}
+
+				touched = true;
+
+			}
+			else {
+				changed = time_changed;
+			}
+
+			if (_file->external != nullptr) changed = true; //The external tree has been replaced since the last build.
+
+			//Use the dependencies the compiler reported for this source last time instead of reading it again.
+			const std::vector<std::string>* deps = (_scan && use_depfiles && path.extension().string() == ".c") ? parser.config.get_config_dependencies(config_type, path) : nullptr;
+
+			if (deps != nullptr) {
+
+				includes.from_depfile = true;
+
+				for (const std::string& dep : *deps) {
+
+					Path_ID dep_id = add_file(std::filesystem::u8path(dep), false);
+					if (dep_id != _file->id) includes.includes.push_back(dep_id);
+
+				}
+
+			}
+			else if (_scan) {
+
+				//Parse directives in file, unchanged files reuse the directives cached by the last build.
+				bool cached = false;
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+
+					const Include_Cache_Entry* cache_entry = parser.config.get_include_cache(path, time, size);
+
+					if (cache_entry != nullptr) {
+
+						includes.directives = cache_entry->directives;
+						includes.guard = cache_entry->guard;
+						cached = true;
+
+					}
+				}
+
+				if (!cached) {
+
+					if (read || File::read_text_file(path, source)) {
+
+						Include_Scanner::scan(source, includes.directives);
+						includes.guard = Include_Scanner::find_guard(includes.directives);
+
+						std::lock_guard<std::mutex> lock(mutex);
+						parser.config.set_include_cache(path, time, size, includes.directives, includes.guard);
+
+					}
+					else {
+						changed = false;
+					}
+
+				}
+
+				resolve_includes(_file, includes);
+
+			}
+
+		}
+
+		std::shared_ptr<const File_Includes> result = _scan ? std::make_shared<const File_Includes>(std::move(includes)) : nullptr;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			_file->exists = exists;
+			_file->changed = _file->changed || changed;
+			_file->touched = _file->touched || touched;
+			_file->time = time;
+			_file->hash = hash;
+			_file->size = size;
+			if (_scan) _file->includes = result;
+
+			--_file->pending_jobs;
+		}
+
+		scanned_condition.notify_all();
+
+	}
+
+	void Dependency_Scanner::scan_external_file(Checked_File* _file, bool _scan) {
+
+		//Nothing in an external include dir changes without changing its fingerprint, so its files aren't even stat'ed.
+		const std::filesystem::path& path = _file->path;
+
+		bool exists = true;
+		File_Includes includes;
+
+		if (_scan) {
+
+			bool cached = false;
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+
+				const Include_Cache_Entry* cache_entry = parser.config.get_include_cache(path);
+
+				if (cache_entry != nullptr) {
+
+					includes.directives = cache_entry->directives;
+					includes.guard = cache_entry->guard;
+					cached = true;
+
+				}
+			}
+
+			if (!cached) {
+
+				std::string source;
+				exists = File::read_text_file(path, source);
+
+				if (exists) {
+
+					Include_Scanner::scan(source, includes.directives);
+					includes.guard = Include_Scanner::find_guard(includes.directives);
+
+					std::lock_guard<std::mutex> lock(mutex);
+					parser.config.set_include_cache(path, 0, (u64)source.length(), includes.directives, includes.guard);
+
+				}
+
+			}
+
+			resolve_includes(_file, includes);
+
+		}
+
+		std::shared_ptr<const File_Includes> result = _scan ? std::make_shared<const File_Includes>(std::move(includes)) : nullptr;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			_file->exists = exists;
+			if (_scan) _file->includes = result;
+
+			--_file->pending_jobs;
+		}
+
+		scanned_condition.notify_all();
+
+	}
+
+	u64 Dependency_Scanner::get_fingerprint(const std::filesystem::path& _dir, const std::vector<std::string>& _subdirs) {
+
+		//Covers the toolchain, the top level of the tree, which is what changes when a compiler or package is upgraded,
+		//and every directory below it that a header was found in, so editing a nested header changes it as well.
+		std::error_code error;
+		u64 hash = Hash::string(compiler);
+
+		std::filesystem::file_time_type compiler_time = std::filesystem::last_write_time(parser.get_compiler_path(compiler), error);
+		if (!error) hash = Hash::combine(hash, (u64)compiler_time.time_since_epoch().count());
+
+		auto hash_dir = [](const std::filesystem::path& _path, u64 _hash) {
+
+			std::error_code error;
+
+			std::filesystem::file_time_type dir_time = std::filesystem::last_write_time(_path, error);
+			if (error) return Hash::combine(_hash, 0);
+
+			_hash = Hash::combine(_hash, (u64)dir_time.time_since_epoch().count());
+
+			//Directory entries come in no particular order, so their hashes are summed.
+			u64 entries = 0;
+
+			for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(_path, error)) {
+
+				std::filesystem::file_time_type entry_time = entry.last_write_time(error);
+				entries += Hash::combine(Hash::string(entry.path().filename().string()), error ? 0 : (u64)entry_time.time_since_epoch().count());
+
+			}
+
+			return Hash::combine(_hash, entries);
+
+		};
+
+		if (!File::directory_exists(_dir)) return 0;
+
+		hash = hash_dir(_dir, hash);
+
+		for (const std::string& subdir : _subdirs) {
+			hash = hash_dir(_dir / std::filesystem::u8path(subdir), Hash::string(subdir, hash));
+		}
+
+		return hash;
+
+	}
+
+	const External_Dir* Dependency_Scanner::find_external_dir(const std::filesystem::path& _path) {
+
+		std::string path = _path.string();
+
+		for (const External_Dir& external_dir : external_dirs) {
+			if (path.compare(0, external_dir.prefix.length(), external_dir.prefix) == 0) return &external_dir;
+		}
+
+		return nullptr;
+
+	}
+
+	void Dependency_Scanner::resolve_includes(Checked_File* _file, File_Includes& _includes) {
+
+		_includes.once = std::any_of(_includes.directives.begin(), _includes.directives.end(), [](const Directive& _directive) { return _directive.type == Directive_Type::Pragma_Once; });
+
+		//Every branch is resolved here, which of them are compiled is only known once the translation unit is walked.
+		for (u32 i = 0; i < _includes.directives.size(); ++i) {
+
+			const Directive& directive = _includes.directives[i];
+			if (directive.type != Directive_Type::Include || directive.computed) continue;
+
+			resolve_include(_file->id, directive.name, directive.angled, _includes.includes);
+			_includes.include_directives.resize(_includes.includes.size(), i);
+
+		}
+
+	}
+
+	void Dependency_Scanner::resolve_include(Path_ID _file, const std::string& _name, bool _angled, std::vector<Path_ID>& _includes) {
+
+		std::filesystem::path path = path_table.get_path(_file);
+
+		if (!_angled) {
+
+			Path_ID dir = path_table.intern(path.has_parent_path() ? path.parent_path() : std::filesystem::path());
+
+			std::filesystem::path local_path = path.has_parent_path() ? path.parent_path() / std::filesystem::u8path(_name) : std::filesystem::u8path(_name);
+			File::format_path(local_path);
+
+			if (stat_cache.file_exists(dir, local_path, _name)) {
+
+				Path_ID include_id = add_file(local_path, true);
+				if (include_id != _file) _includes.push_back(include_id);
+
+				return;
+
+			}
+
+		}
+
+		//Fallback to include.
+		for (u64 i = 0; i < parser.incl_dirs.size(); ++i) {
+
+			std::filesystem::path incl_path = parser.incl_dirs[i] / std::filesystem::u8path(_name);
+			File::format_path(incl_path);
+
+			if (!stat_cache.file_exists(incl_dir_ids[i], incl_path, _name)) continue;
+
+			Path_ID include_id = add_file(incl_path, true);
+			if (include_id != _file) _includes.push_back(include_id);
+
+		}
+
+	}
+
+	void Dependency_Scanner::wait_for_file(Path_ID _id, bool& _changed, std::shared_ptr<const File_Includes>& _includes) {
+
+		//Take a snapshot, a file from a depfile can still be scanned later when another file includes it.
+		std::unique_lock<std::mutex> lock(mutex);
+
+		Checked_File* file = get_file(_id);
+		scanned_condition.wait(lock, [file]() { return file->pending_jobs <= 0; });
+
+		_changed = file->changed;
+		_includes = file->includes;
+
+	}
+
+	void Dependency_Scanner::wait() {
+		job_pool.wait();
+	}
+
+	bool Dependency_Scanner::should_rebuild(const std::filesystem::path& _source, Rebuild_Explanation* _explanation, bool _command_changed) {
+
+		Path_ID id = add_file(_source, true);
+
+		Walk_State state;
+		state.preprocessor = predefined;
+
+		walk(id, Region::Live, true, state);
+
+		//Computed includes that couldn't be expanded are taken from the depfile of the last compile instead.
+		if (state.unresolved && !state.rebuild) {
+
+			std::vector<std::filesystem::path> deps;
+
+			if (compiler_spec != nullptr && Depfile::read(compiler_spec->get_dep_path(_source, config_type, parser), deps)) {
+
+				state.stack.push_back(id);
+
+				for (const std::filesystem::path& dep : deps) {
+					walk(add_file(dep, false), Region::Live, false, state);
+				}
+
+				state.stack.pop_back();
+
+			}
+			else {
+				state.rebuild = true;
+			}
+
+		}
+
+		bool rebuild = state.rebuild;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!get_file(id)->exists) return false;
+		}
+
+		if (_command_changed) rebuild = true;
+
+		//Rebuild source file if object file does not exist.
+		std::filesystem::path obj_file_path;
+
+		if (!rebuild && _source.extension().string() == ".c") {
+
+			obj_file_path = parser.get_obj_path(_source, config_type);
+
+			if (!File::file_exists(obj_file_path)) rebuild = true;
+
+		}
+
+		if (_explanation != nullptr && rebuild) {
+
+			//A different command rebuilds the object whatever else changed, unless it was never compiled in the first place.
+			if (_command_changed && parser.config.get_config_dependencies(config_type, _source) != nullptr) {
+				_explanation->reason = Rebuild_Reason::Command_Changed;
+			}
+			else if (!state.rebuild) {
+
+				_explanation->reason = Rebuild_Reason::Missing_Object;
+				_explanation->detail = obj_file_path.string();
+
+			}
+			else if (state.trigger.empty()) {
+				_explanation->reason = Rebuild_Reason::Unresolved_Include;
+			}
+			else {
+
+				std::lock_guard<std::mutex> lock(mutex);
+
+				for (Path_ID trigger_id : state.trigger) {
+					_explanation->chain.push_back(get_file(trigger_id)->path);
+				}
+
+				const Checked_File* trigger = get_file(state.trigger.back());
+
+				if (trigger->id != id) _explanation->reason = trigger->exists ? Rebuild_Reason::Header_Changed : Rebuild_Reason::Header_Removed;
+				else {
+
+					Config_Timestamps* timestamps = parser.config.get_config_timestamps(config_type);
+					bool built_before = (timestamps != nullptr && timestamps->timestamps.find(trigger->path.string()) != timestamps->timestamps.end());
+
+					_explanation->reason = built_before ? Rebuild_Reason::Source_Changed : Rebuild_Reason::New_Source;
+
+				}
+
+			}
+
+		}
+
+		return rebuild;
+
+	}
+
+	void Dependency_Scanner::walk(Path_ID _id, Region _region, bool _follow, Walk_State& _state) {
+
+		//Walks the translation unit the way the compiler would, so includes in blocks that are never compiled are skipped.
+		//Guarded files are entered once per translation unit, unguarded ones every time they are included unless that would be a cycle
+		//or the macros and files their last walk depended on are unchanged, in which case that walk is replayed.
+		//The includes are kept on an explicit stack instead of recursing, so deep include chains can't exhaust the call stack.
+		size_t base = _state.frames.size();
+
+		enter_file(_id, _region, _follow, _state);
+
+		while (_state.frames.size() > base) {
+
+			if (_state.rebuild && _state.stop_on_change) {
+
+				while (_state.frames.size() > base) leave_file(_state);
+				break;
+
+			}
+
+			Walk_Frame& frame = _state.frames.back();
+
+			//An include only continues with the next match or directive once everything it includes has been walked.
+			if (frame.next_pending < frame.pending.size()) {
+
+				//Headers listed in a depfile aren't followed any further.
+				Path_ID include = frame.pending[frame.next_pending++];
+				enter_file(include, frame.pending_region, !frame.includes->from_depfile, _state);
+				continue;
+
+			}
+
+			if (frame.directive >= frame.includes->directives.size()) {
+
+				leave_file(_state);
+				continue;
+
+			}
+
+			evaluate_directive(frame, _state);
+
+		}
+
+	}
+
+	void Dependency_Scanner::enter_file(Path_ID _id, Region _region, bool _follow, Walk_State& _state) {
+
+		if (_state.rebuild && _state.stop_on_change) return;
+
+		if (_id >= _state.entered.size()) {
+
+			_state.entered.resize((size_t)_id + 1, false);
+			_state.active.resize((size_t)_id + 1, false);
+
+		}
+
+		if (_state.recording > 0) _state.file_accesses.push_back({ _id, _state.active[_id], _state.entered[_id] });
+		if (_state.active[_id]) return;
+
+		bool changed = false;
+		std::shared_ptr<const File_Includes> includes;
+
+		wait_for_file(_id, changed, includes);
+
+		bool guarded = (includes != nullptr && (includes->once || !includes->guard.empty()));
+		if (_state.entered[_id] && (guarded || !_follow || includes == nullptr)) return;
+
+		//Another spelling or copy of the same header has already defined its guard, so the compiler skips all of it.
+		if (includes != nullptr && !includes->guard.empty() && _state.preprocessor.get_state(includes->guard) == Macro_State::Defined) return;
+
+		_state.entered[_id] = true;
+		if (_state.recording > 0) _state.file_accesses.push_back({ _id, false, true, true });
+
+		if (changed) {
+
+			if (!_state.rebuild) {
+
+				_state.trigger = _state.stack;
+				_state.trigger.push_back(_id);
+
+			}
+
+			_state.rebuild = true;
+			if (_state.stop_on_change) return;
+
+		}
+
+		if (!_follow || includes == nullptr) return;
+
+		bool record = (!guarded && !includes->from_depfile);
+		if (record && replay(_id, _region, _state)) return;
+
+		Walk_Frame& frame = _state.frames.emplace_back();
+		frame.id = _id;
+		frame.region = _region;
+		frame.includes = includes;
+
+		if (record) {
+
+			frame.recording = true;
+			frame.macro_access = _state.preprocessor.accesses.size();
+			frame.file_access = _state.file_accesses.size();
+			frame.assume_undefined = _state.preprocessor.assume_undefined;
+
+			++_state.recording;
+			_state.preprocessor.record = true;
+
+		}
+
+		_state.active[_id] = true;
+		_state.stack.push_back(_id);
+
+		//The compiler already listed every header this source reached.
+		if (includes->from_depfile) {
+
+			frame.pending = includes->includes;
+			frame.pending_region = _region;
+
+			return;
+
+		}
+
+		frame.guard_directive = (u32)includes->directives.size();
+
+		if (!includes->guard.empty()) {
+			for (frame.guard_directive = 0; includes->directives[frame.guard_directive].type == Directive_Type::Pragma_Once; ++frame.guard_directive);
+		}
+
+	}
+
+	void Dependency_Scanner::leave_file(Walk_State& _state) {
+
+		Walk_Frame& frame = _state.frames.back();
+
+		if (frame.recording) {
+
+			//A walk that stopped at a changed file didn't see all of it.
+			if (!_state.rebuild || !_state.stop_on_change) record_summary(frame, _state);
+
+			if (--_state.recording <= 0) {
+
+				_state.preprocessor.record = false;
+				_state.preprocessor.accesses.clear();
+				_state.file_accesses.clear();
+
+			}
+
+		}
+
+		_state.active[frame.id] = false;
+		_state.stack.pop_back();
+		_state.frames.pop_back();
+
+	}
+
+	void Dependency_Scanner::record_summary(const Walk_Frame& _frame, Walk_State& _state) {
+
+		Walk_Summary& summary = _state.summaries[_frame.id];
+		summary = Walk_Summary();
+
+		summary.region = _frame.region;
+		summary.assume_undefined = _frame.assume_undefined;
+		summary.assume_undefined_after = _state.preprocessor.assume_undefined;
+		summary.unresolved = _state.unresolved;
+
+		//Only what was read before the walk changed it is an input, later reads see the walk's own writes.
+		std::unordered_set<std::string> read_macros;
+		std::unordered_set<std::string> written_macros;
+
+		for (size_t i = _frame.macro_access; i < _state.preprocessor.accesses.size(); ++i) {
+
+			const Macro_Access& access = _state.preprocessor.accesses[i];
+
+			if (access.write) {
+				if (written_macros.insert(access.name).second) summary.writes.emplace_back(access.name, Macro());
+			}
+			else if (written_macros.find(access.name) == written_macros.end() && read_macros.insert(access.name).second) {
+				summary.reads.push_back(access);
+			}
+
+		}
+
+		for (std::pair<std::string, Macro>& write : summary.writes) {
+			write.second = _state.preprocessor.macros[write.first];
+		}
+
+		std::unordered_set<Path_ID> read_files;
+		std::unordered_set<Path_ID> written_files;
+
+		for (size_t i = _frame.file_access; i < _state.file_accesses.size(); ++i) {
+
+			//The file itself is always active while it's being walked.
+			const File_Access& access = _state.file_accesses[i];
+			if (access.id == _frame.id) continue;
+
+			if (access.write) written_files.insert(access.id);
+			else if (written_files.find(access.id) == written_files.end() && read_files.insert(access.id).second) summary.files.push_back(access);
+
+		}
+
+	}
+
+	bool Dependency_Scanner::replay(Path_ID _id, Region _region, Walk_State& _state) {
+
+		const auto& it = _state.summaries.find(_id);
+		if (it == _state.summaries.end()) return false;
+
+		const Walk_Summary& summary = it->second;
+		Preprocessor& preprocessor = _state.preprocessor;
+
+		if (summary.region != _region || summary.assume_undefined != preprocessor.assume_undefined) return false;
+
+		for (const File_Access& access : summary.files) {
+			if (_state.active[access.id] != access.active || _state.entered[access.id] != access.entered) return false;
+		}
+
+		for (const Macro_Access& access : summary.reads) {
+			if (preprocessor.get_digest(access.name) != access.digest) return false;
+		}
+
+		//Walks this one is nested in depend on the same inputs.
+		if (_state.recording > 0) {
+
+			_state.file_accesses.insert(_state.file_accesses.end(), summary.files.begin(), summary.files.end());
+			preprocessor.accesses.insert(preprocessor.accesses.end(), summary.reads.begin(), summary.reads.end());
+
+		}
+
+		for (const std::pair<std::string, Macro>& write : summary.writes) {
+
+			if (_state.recording > 0) preprocessor.accesses.push_back({ write.first, 0, true });
+			preprocessor.macros[write.first] = write.second;
+
+		}
+
+		preprocessor.assume_undefined = summary.assume_undefined_after;
+		if (summary.unresolved) _state.unresolved = true;
+
+		return true;
+
+	}
+
+	void Dependency_Scanner::evaluate_directive(Walk_Frame& _frame, Walk_State& _state) {
+
+		const File_Includes& includes = *_frame.includes;
+
+		u32 i = _frame.directive++;
+		const Directive& directive = includes.directives[i];
+		Region region = _frame.conditionals.empty() ? _frame.region : _frame.conditionals.back().region;
+
+		switch (directive.type) {
+
+			case Directive_Type::If:
+			case Directive_Type::Ifdef:
+			case Directive_Type::Ifndef: {
+
+				Conditional& conditional = _frame.conditionals.emplace_back();
+				conditional.parent = region;
+
+				//The guard itself can't be defined yet, even when the macros of an unresolved include are unknown.
+				bool guard = (i == _frame.guard_directive);
+
+				enter_branch(conditional, (region == Region::Dead) ? Condition::False : guard ? Condition::True : evaluate(directive, _state.preprocessor));
+				break;
+
+			}
+
+			case Directive_Type::Elif:
+			case Directive_Type::Else: {
+
+				if (_frame.conditionals.empty()) break;
+
+				Conditional& conditional = _frame.conditionals.back();
+				bool skip = (conditional.parent == Region::Dead || conditional.taken == Condition::True);
+
+				enter_branch(conditional, skip ? Condition::False : (directive.type == Directive_Type::Else) ? Condition::True : evaluate(directive, _state.preprocessor));
+				break;
+
+			}
+
+			case Directive_Type::Endif: {
+
+				if (!_frame.conditionals.empty()) _frame.conditionals.pop_back();
+				break;
+
+			}
+
+			//Macros defined in blocks that might not be compiled can't be relied on either way.
+			case Directive_Type::Define: {
+
+				if (region == Region::Live) _state.preprocessor.define(directive.name, directive.value, directive.function_like);
+				else if (region == Region::Maybe) _state.preprocessor.forget(directive.name);
+
+				break;
+
+			}
+
+			case Directive_Type::Undef: {
+
+				if (region == Region::Live) _state.preprocessor.undefine(directive.name);
+				else if (region == Region::Maybe) _state.preprocessor.forget(directive.name);
+
+				break;
+
+			}
+
+			case Directive_Type::Include: {
+
+				size_t first = _frame.next_include;
+				while (_frame.next_include < includes.include_directives.size() && includes.include_directives[_frame.next_include] == i) ++_frame.next_include;
+
+				if (region == Region::Dead) break;
+
+				_frame.pending.clear();
+				_frame.next_pending = 0;
+
+				if (directive.computed) {
+
+					std::string name;
+					bool angled = false;
+
+					if (!_state.preprocessor.expand_include(directive.name, name, angled)) {
+
+						_state.preprocessor.assume_undefined = false;
+						_state.unresolved = true;
+
+						break;
+
+					}
+
+					resolve_include(_frame.id, name, angled, _frame.pending);
+
+					if (_frame.pending.empty() && !angled) _state.preprocessor.assume_undefined = false;
+					_frame.pending_region = (_frame.pending.size() > 1) ? Region::Maybe : region;
+
+					break;
+
+				}
+
+				//A missing project header could define anything, while system headers are assumed to stick to reserved names.
+				if (first == _frame.next_include && !directive.angled) _state.preprocessor.assume_undefined = false;
+
+				//Only the first match is compiled, but which one that is isn't tracked, so none of their macros are trusted.
+				_frame.pending.assign(includes.includes.begin() + first, includes.includes.begin() + _frame.next_include);
+				_frame.pending_region = (_frame.next_include - first > 1) ? Region::Maybe : region;
+
+				break;
+
+			}
+
+			case Directive_Type::Pragma_Once: break;
+
+		}
+
+	}
+
+	Condition Dependency_Scanner::evaluate(const Directive& _directive, Preprocessor& _preprocessor) {
+
+		if (_directive.type == Directive_Type::If || _directive.type == Directive_Type::Elif) return _preprocessor.evaluate(_directive.name);
+		if (_directive.name.empty()) return Condition::Unknown;
+
+		Macro_State state = _preprocessor.get_state(_directive.name);
+		if (state == Macro_State::Unknown) return Condition::Unknown;
+
+		return ((state == Macro_State::Defined) == (_directive.type == Directive_Type::Ifdef)) ? Condition::True : Condition::False;
+
+	}
+
+	void Dependency_Scanner::enter_branch(Conditional& _conditional, Condition _condition) {
+
+		if (_conditional.parent == Region::Dead || _conditional.taken == Condition::True || _condition == Condition::False) _conditional.region = Region::Dead;
+		else if (_conditional.parent == Region::Live && _conditional.taken == Condition::False && _condition == Condition::True) _conditional.region = Region::Live;
+		else _conditional.region = Region::Maybe;
+
+		if (_condition == Condition::True) _conditional.taken = Condition::True;
+		else if (_condition == Condition::Unknown && _conditional.taken == Condition::False) _conditional.taken = Condition::Unknown;
+
+	}
+
+	bool Dependency_Scanner::includes_file(const std::filesystem::path& _path, const std::filesystem::path& _target) {
+
+		//Walk the include edges recorded while scanning, starting from the given file.
+		Path_ID id = 0;
+		Path_ID target = 0;
+
+		if (!path_table.find(_path, id) || !path_table.find(_target, target)) return false;
+
+		std::vector<bool> visited;
+		std::vector<Path_ID> stack = { id };
+
+		while (!stack.empty()) {
+
+			Path_ID cur = stack.back();
+			stack.pop_back();
+
+			if (cur < visited.size() && visited[cur]) continue;
+			if (cur >= visited.size()) visited.resize((size_t)cur + 1, false);
+
+			visited[cur] = true;
+
+			bool changed = false;
+			std::shared_ptr<const File_Includes> includes;
+
+			wait_for_file(cur, changed, includes);
+			if (includes == nullptr) continue;
+
+			for (Path_ID include : includes->includes) {
+
+				if (include == target) return true;
+				stack.push_back(include);
+
+			}
+
+		}
+
+		return false;
+
+	}
+
+	void Dependency_Scanner::add_dependencies(const std::vector<std::filesystem::path>& _deps) {
+
+		for (const std::filesystem::path& dep : _deps) {
+			add_file(dep, false);
+		}
+
+	}
+
+	bool Dependency_Scanner::store_timestamps() {
+
+		wait();
+
+		bool touched = false;
+
+		//Files in external include dirs are covered by the fingerprint of their dir instead.
+		for (const Checked_File& file : files) {
+
+			if (!file.added || !file.exists || file.external != nullptr) continue;
+
+			parser.config.set_config_timestamp(config_type, file.path, file.time, file.hash, file.size);
+			touched = touched || file.touched;
+
+		}
+
+		//Directories headers were found in this time join the ones from earlier builds,
+		//sources that weren't scanned still depend on those.
+		for (External_Dir& external_dir : external_dirs) {
+
+			std::set<std::string> subdirs(external_dir.subdirs.begin(), external_dir.subdirs.end());
+
+			for (const Checked_File& file : files) {
+
+				if (!file.added || !file.exists || file.external != &external_dir) continue;
+
+				std::string subdir = std::filesystem::path(file.path.string().substr(external_dir.prefix.length())).parent_path().string();
+				if (!subdir.empty()) subdirs.insert(subdir);
+
+			}
+
+			if (subdirs.size() != external_dir.subdirs.size()) {
+
+				external_dir.subdirs.assign(subdirs.begin(), subdirs.end());
+				external_dir.fingerprint = get_fingerprint(external_dir.path, external_dir.subdirs);
+
+			}
+
+			parser.config.external_fingerprints[external_dir.path.string()] = external_dir.fingerprint;
+			parser.config.external_subdirs[external_dir.path.string()] = external_dir.subdirs;
+
+		}
+
+		return touched;
+
+	}
+
+	void Dependency_Scanner::print_stats() {
+
+		CBUILD_TRACE("Prefetched stats: {} ({})", prefetched_files, Stat_Batch::method_to_string(stat_method));
+		if (propagated) CBUILD_TRACE("Changed files: {}, affected sources: {} of {}", suspect_files, affected_sources, total_sources);
+		stat_cache.print_stats();
+
+	}
+
+}
\ No newline at end of file
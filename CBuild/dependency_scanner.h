@@ -0,0 +1,214 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <memory>
+#include <condition_variable>
+#include <filesystem>
+
+#include "types.h"
+#include "config.h"
+#include "job_pool.h"
+#include "path_table.h"
+#include "stat_cache.h"
+#include "stat_batch.h"
+#include "preprocessor.h"
+#include "compiler_spec.h"
+#include "hash.h"
+#include "explain.h"
+
+namespace CBuild {
+
+	struct Parser;
+
+	enum class Region : u8 {
+
+		Dead, //Inside a conditional block that is never compiled.
+		Maybe, //Depends on a condition that couldn't be evaluated.
+		Live,
+
+	};
+
+	struct Conditional {
+
+		Region parent = Region::Live;
+		Region region = Region::Live;
+		Condition taken = Condition::False; //Whether an earlier branch of the same #if chain has been taken.
+
+	};
+
+	struct File_Includes {
+
+		std::vector<Directive> directives; //Empty when the includes came from a depfile.
+		std::vector<Path_ID> includes;
+		std::vector<u32> include_directives; //Index of the directive each include was resolved from.
+		std::string guard = ""; //Include guard macro, empty if the file isn't guarded.
+		bool once = false; //#pragma once
+		bool from_depfile = false;
+
+	};
+
+	struct Walk_Frame {
+
+		Path_ID id = 0;
+		Region region = Region::Live;
+		std::shared_ptr<const File_Includes> includes;
+		std::vector<Conditional> conditionals;
+		u32 directive = 0; //Next directive to evaluate.
+		u32 guard_directive = 0;
+		size_t next_include = 0;
+
+		//Files the current include directive resolved to, entered one after the other.
+		std::vector<Path_ID> pending;
+		size_t next_pending = 0;
+		Region pending_region = Region::Live;
+
+		//Unguarded files are recorded from here on, so including them again can be replayed.
+		bool recording = false;
+		size_t macro_access = 0;
+		size_t file_access = 0;
+		bool assume_undefined = true;
+
+	};
+
+	struct File_Access {
+
+		Path_ID id = 0;
+		bool active = false;
+		bool entered = false;
+		bool write = false; //The file was entered, later reads of it don't depend on the state before the walk.
+
+	};
+
+	struct Walk_Summary {
+
+		//What walking an unguarded file depended on and left behind.
+		//Walking it again with the same inputs evaluates the same directives, so its effects are applied instead.
+		Region region = Region::Live;
+		bool assume_undefined = true;
+		std::vector<Macro_Access> reads; //Macros read before the walk wrote them, with what they looked like.
+		std::vector<File_Access> files; //Files reached before the walk entered them, with whether they were active or entered.
+		std::vector<std::pair<std::string, Macro>> writes; //Macros as the walk left them.
+		bool assume_undefined_after = true;
+		bool unresolved = false;
+
+	};
+
+	struct Walk_State {
+
+		Preprocessor preprocessor;
+		std::vector<bool> entered; //Indexed by path ID, guarded files are entered once per translation unit.
+		std::vector<bool> active; //Files currently being walked, re-entering one of these is an include cycle.
+		std::vector<Walk_Frame> frames; //Files whose directives are being evaluated, the innermost include last.
+		std::vector<Path_ID> stack; //Files currently being walked, in include order.
+		std::vector<Path_ID> trigger; //Include chain from the source to the first changed file.
+		bool rebuild = false;
+		bool unresolved = false; //A computed include couldn't be expanded.
+		bool stop_on_change = true; //Stop at the first changed file instead of walking the whole translation unit.
+
+		std::vector<File_Access> file_accesses; //Logged while an unguarded file is being walked.
+		std::unordered_map<Path_ID, Walk_Summary> summaries; //Last complete walk of each unguarded file.
+		u32 recording = 0;
+
+	};
+
+	struct External_Dir {
+
+		std::filesystem::path path;
+		std::string prefix; //Path followed by a separator, for matching the files inside it.
+		std::vector<std::string> subdirs; //Sorted directories below the path that headers were found in, relative to it.
+		u64 fingerprint = 0;
+		bool unchanged = false; //Same fingerprint as the last build, so none of its files are checked.
+
+	};
+
+	struct Checked_File {
+
+		Path_ID id = 0;
+		std::filesystem::path path;
+		bool added = false;
+		bool exists = false;
+		bool changed = false; //The file itself differs from the last build.
+		bool touched = false; //The stored timestamp or hash is out of date, even if the content is the same.
+		bool scanned = false; //Includes were resolved, files only listed in a depfile just get their timestamp checked.
+		u64 time = 0;
+		u64 size = 0;
+		u64 hash = 0; //Content digest, reused from the last build while the timestamp and size match.
+		std::shared_ptr<const File_Includes> includes;
+		const External_Dir* external = nullptr;
+
+		u32 pending_jobs = 0;
+
+	};
+
+	struct Dependency_Scanner {
+
+		Parser& parser;
+		Config_Type config_type;
+		std::string compiler;
+		Compiler_Spec* compiler_spec = nullptr;
+
+		Job_Pool job_pool;
+		Path_Table path_table;
+		Stat_Cache stat_cache;
+		std::vector<Path_ID> incl_dir_ids;
+		Preprocessor predefined; //Macros the compiler defines before reading a source.
+		std::vector<External_Dir> external_dirs;
+		bool use_depfiles = true; //Sources with dependencies from their last compile are not scanned.
+		bool hash_tokens = false; //Digests cover the significant tokens instead of the raw bytes.
+
+		//Stat results fetched in one batch before scanning starts, indexed by path ID and read-only afterwards.
+		std::vector<File_Info> file_infos;
+		std::vector<bool> prefetched;
+		Stat_Method stat_method = Stat_Method::Sequential;
+		u64 prefetched_files = 0;
+
+		//Sources reached from the files that differ from the last build, the rest are known to be up-to-date without a scan.
+		bool propagated = false;
+		u64 suspect_files = 0;
+		u64 affected_sources = 0;
+		u64 total_sources = 0;
+
+		//Memo table shared by all scan jobs and indexed by path ID, every file is scanned at most once.
+		std::mutex mutex;
+		std::condition_variable scanned_condition;
+		std::deque<Checked_File> files;
+
+		Dependency_Scanner(Parser& _parser, Config_Type _config_type, const std::string& _compiler, u32 _job_count);
+		~Dependency_Scanner();
+
+		void prefetch(const std::vector<std::filesystem::path>& _sources);
+		bool get_file_info(Path_ID _id, const std::filesystem::path& _path, File_Info& _info);
+		bool find_affected_sources(const std::vector<std::filesystem::path>& _sources, std::vector<bool>& _affected);
+		bool is_suspect(const std::filesystem::path& _path, const Config_Timestamps& _timestamps);
+		Path_ID add_file(const std::filesystem::path& _path, bool _scan);
+		Checked_File* get_file(Path_ID _id);
+		void scan_file(Checked_File* _file, bool _scan);
+		void scan_external_file(Checked_File* _file, bool _scan);
+		u64 get_fingerprint(const std::filesystem::path& _dir, const std::vector<std::string>& _subdirs);
+		const External_Dir* find_external_dir(const std::filesystem::path& _path);
+		void resolve_includes(Checked_File* _file, File_Includes& _includes);
+		void resolve_include(Path_ID _file, const std::string& _name, bool _angled, std::vector<Path_ID>& _includes);
+		void wait_for_file(Path_ID _id, bool& _changed, std::shared_ptr<const File_Includes>& _includes);
+		void wait();
+
+		bool should_rebuild(const std::filesystem::path& _source, Rebuild_Explanation* _explanation = nullptr, bool _command_changed = false);
+		void walk(Path_ID _id, Region _region, bool _follow, Walk_State& _state);
+		void enter_file(Path_ID _id, Region _region, bool _follow, Walk_State& _state);
+		void leave_file(Walk_State& _state);
+		void record_summary(const Walk_Frame& _frame, Walk_State& _state);
+		bool replay(Path_ID _id, Region _region, Walk_State& _state);
+		void evaluate_directive(Walk_Frame& _frame, Walk_State& _state);
+		static Condition evaluate(const Directive& _directive, Preprocessor& _preprocessor);
+		static void enter_branch(Conditional& _conditional, Condition _condition);
+		bool includes_file(const std::filesystem::path& _path, const std::filesystem::path& _target);
+		void add_dependencies(const std::vector<std::filesystem::path>& _deps);
+		bool store_timestamps();
+		void print_stats();
+
+	};
+
+}
\ No newline at end of file
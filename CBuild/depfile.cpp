@@ -0,0 +1,130 @@
+#include "pch.h"
+#include "depfile.h"
+#include "file.h"
+
+namespace CBuild {
+
+	bool Depfile::read(const std::filesystem::path& _path, std::vector<std::filesystem::path>& _deps) {
+
+		_deps.clear();
+
+		std::ifstream input(_path, std::ios::in | std::ios::binary);
+		if (!input.good()) return false;
+
+		std::string source((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+		parse(source, _deps);
+
+		return true;
+
+	}
+
+	void Depfile::parse(const std::string& _source, std::vector<std::filesystem::path>& _deps) {
+
+		//Only the first rule is read, the phony rules added by -MP follow after it.
+		bool reading_deps = false;
+		std::string dep;
+
+		auto add_dep = [&]() {
+
+			if (reading_deps && !dep.empty()) {
+
+				std::filesystem::path dep_path = std::filesystem::u8path(dep);
+				File::format_path(dep_path);
+
+				_deps.push_back(dep_path);
+
+			}
+
+			dep.clear();
+
+		};
+
+		size_t length = _source.length();
+		size_t i = 0;
+
+		while (i < length) {
+
+			char cur = _source[i];
+			char next = (i + 1 < length) ? _source[i + 1] : '\0';
+
+			//Escaped characters and line continuations. Other backslashes are part of Windows paths.
+			if (cur == '\\') {
+
+				if (next == '\n') {
+
+					add_dep();
+					i += 2;
+
+				}
+				else if (next == '\r' && i + 2 < length && _source[i + 2] == '\n') {
+
+					add_dep();
+					i += 3;
+
+				}
+				else if (next == ' ' || next == '#') {
+
+					dep += next;
+					i += 2;
+
+				}
+				else {
+
+					dep += cur;
+					++i;
+
+				}
+
+				continue;
+
+			}
+
+			if (cur == '$' && next == '$') {
+
+				dep += '$';
+				i += 2;
+
+				continue;
+
+			}
+
+			if (cur == ' ' || cur == '\t') {
+
+				add_dep();
+				++i;
+
+				continue;
+
+			}
+
+			if (cur == '\n' || cur == '\r') {
+
+				add_dep();
+				if (reading_deps) return;
+
+				++i;
+				continue;
+
+			}
+
+			//The colon ending the target list is followed by whitespace, unlike drive letters in Windows paths.
+			if (cur == ':' && !reading_deps && (next == '\0' || next == ' ' || next == '\t' || next == '\n' || next == '\r')) {
+
+				dep.clear();
+				reading_deps = true;
+				++i;
+
+				continue;
+
+			}
+
+			dep += cur;
+			++i;
+
+		}
+
+		add_dep();
+
+	}
+
+}
\ No newline at end of file
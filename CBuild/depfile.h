@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "types.h"
+
+namespace CBuild {
+
+	struct Depfile {
+
+		static bool read(const std::filesystem::path& _path, std::vector<std::filesystem::path>& _deps);
+		static void parse(const std::string& _source, std::vector<std::filesystem::path>& _deps);
+
+	};
+
+}
\ No newline at end of file
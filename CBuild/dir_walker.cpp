@@ -0,0 +1,134 @@
+#include "pch.h"
+#include "dir_walker.h"
+#include "glob.h"
+
+#include <algorithm>
+
+namespace CBuild {
+
+	Dir_Walker::Dir_Walker(Config& _config, u32 _job_count) : config(_config), job_pool(_job_count) {}
+
+	void Dir_Walker::add_root(const std::filesystem::path& _dir, u32 _depth) {
+
+		job_pool.submit("", [this, _dir, _depth]() {
+
+			walk_dir(_dir, _depth);
+			return true;
+
+		});
+
+	}
+
+	void Dir_Walker::walk_dir(const std::filesystem::path& _dir, u32 _depth) {
+
+		std::string key = _dir.string();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			const auto& it = depths.find(key);
+			if (it != depths.end() && it->second >= _depth) return;
+
+			depths[key] = _depth;
+		}
+
+		if (is_excluded(_dir)) return;
+
+		//The current directory is listed for patterns without a directory, but its entries are given without a './'.
+		std::filesystem::path dir = _dir.empty() ? std::filesystem::path(".") : _dir;
+
+		std::error_code error;
+
+		//Same clock as the file timestamps, so the manifest can check listings with the rest of its snapshot.
+		File_Info info;
+		if (!File::get_info(dir, info)) return;
+
+		Dir_Listing listing;
+		listing.time = info.time;
+
+		bool cached = false;
+
+		//A directory that hasn't been modified still has the same entries, so only its subdirectories have to be checked.
+		const auto& cache_it = config.dir_listings.find(key);
+
+		if (cache_it != config.dir_listings.end() && cache_it->second.time == listing.time) {
+
+			listing = cache_it->second;
+			cached = true;
+
+		}
+		else {
+
+			for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(dir, error)) {
+
+				std::string name = entry.path().filename().u8string();
+
+				//Symlinked directories aren't followed, they could point back up the tree.
+				if (entry.is_directory(error) && !entry.is_symlink(error)) listing.dirs.push_back(name);
+				else if (entry.is_regular_file(error)) listing.files.push_back(name);
+
+			}
+
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if (cached) ++cached_dirs;
+			else ++listed_dirs;
+
+			for (const std::string& file : listing.files) {
+
+				std::filesystem::path path = _dir / std::filesystem::u8path(file);
+				File::format_path(path);
+
+				files.push_back(path);
+
+			}
+
+			listings[key] = listing;
+		}
+
+		if (_depth <= 0) return;
+
+		for (const std::string& sub_dir : listing.dirs) {
+
+			std::filesystem::path path = _dir / std::filesystem::u8path(sub_dir);
+			File::format_path(path);
+
+			u32 depth = (_depth == Glob::unlimited_depth) ? _depth : _depth - 1;
+
+			job_pool.submit("", [this, path, depth]() {
+
+				walk_dir(path, depth);
+				return true;
+
+			});
+
+		}
+
+	}
+
+	bool Dir_Walker::is_excluded(const std::filesystem::path& _path) {
+
+		std::string path = _path.string();
+
+		for (const std::string& exclude : excludes) {
+			if (Glob::match(exclude, path)) return true;
+		}
+
+		return false;
+
+	}
+
+	void Dir_Walker::wait() {
+
+		job_pool.wait();
+
+		//Jobs finish in any order, sorting keeps the build order stable.
+		std::sort(files.begin(), files.end());
+		files.erase(std::unique(files.begin(), files.end()), files.end());
+
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <unordered_map>
+#include <filesystem>
+
+#include "types.h"
+#include "config.h"
+#include "job_pool.h"
+
+namespace CBuild {
+
+	struct Dir_Walker {
+
+		Config& config;
+		Job_Pool job_pool;
+		std::vector<std::string> excludes;
+
+		//Shared by the listing jobs.
+		std::mutex mutex;
+		std::unordered_map<std::string, u32> depths; //Deepest walk started from each directory, so overlapping roots list it once.
+		std::unordered_map<std::string, Dir_Listing> listings; //Every directory listed in this walk, replaces the cached listings when done.
+		std::vector<std::filesystem::path> files;
+
+		u64 listed_dirs = 0;
+		u64 cached_dirs = 0;
+
+		Dir_Walker(Config& _config, u32 _job_count);
+
+		void add_root(const std::filesystem::path& _dir, u32 _depth);
+		void walk_dir(const std::filesystem::path& _dir, u32 _depth);
+		bool is_excluded(const std::filesystem::path& _path);
+		void wait();
+
+	};
+
+}
\ No newline at end of file
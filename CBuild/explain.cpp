@@ -0,0 +1,122 @@
+#include "pch.h"
+#include "explain.h"
+#include "include_report.h"
+#include "file.h"
+
+#include <map>
+
+namespace CBuild {
+
+	const char* Explain::reason_to_string(Rebuild_Reason _reason) {
+
+		switch (_reason) {
+
+			case Rebuild_Reason::None: return "up_to_date";
+			case Rebuild_Reason::Forced: return "forced";
+			case Rebuild_Reason::Command_Changed: return "command_changed";
+			case Rebuild_Reason::Missing_Object: return "missing_object";
+			case Rebuild_Reason::New_Source: return "new_source";
+			case Rebuild_Reason::Source_Changed: return "source_changed";
+			case Rebuild_Reason::Header_Changed: return "header_changed";
+			case Rebuild_Reason::Header_Removed: return "header_removed";
+			case Rebuild_Reason::Unresolved_Include: return "unresolved_include";
+
+		}
+
+		return "";
+
+	}
+
+	std::string Explain::describe(const Rebuild_Explanation& _explanation) {
+
+		std::string trigger = _explanation.chain.empty() ? "" : _explanation.chain.back().string();
+
+		switch (_explanation.reason) {
+
+			case Rebuild_Reason::None: return "up-to-date";
+			case Rebuild_Reason::Forced: return "forced rebuild";
+			case Rebuild_Reason::Command_Changed: return "compile command changed";
+			case Rebuild_Reason::Missing_Object: return "object file '" + _explanation.detail + "' is missing";
+			case Rebuild_Reason::New_Source: return "not built before";
+			case Rebuild_Reason::Source_Changed: return "source changed";
+			case Rebuild_Reason::Header_Changed: return "header '" + trigger + "' changed";
+			case Rebuild_Reason::Header_Removed: return "header '" + trigger + "' was removed";
+			case Rebuild_Reason::Unresolved_Include: return "computed include couldn't be expanded and there's no depfile";
+
+		}
+
+		return "";
+
+	}
+
+	void Explain::print(const Rebuild_Explanation& _explanation) {
+
+		std::string line = "'" + _explanation.source.string() + "': " + describe(_explanation);
+
+		//Headers a few levels deep are easier to track down with the chain that reached them.
+		if (_explanation.chain.size() > 2) {
+
+			line += ", via ";
+
+			for (u64 i = 0; i < _explanation.chain.size(); ++i) {
+				line += (i > 0 ? " -> " : "") + _explanation.chain[i].string();
+			}
+
+		}
+
+		CBUILD_TRACE("{} [{:.3f} ms]", line, _explanation.decide_time * 1000.0);
+
+	}
+
+	void Explain::print_summary(const std::vector<Rebuild_Explanation>& _explanations) {
+
+		std::map<Rebuild_Reason, u64> counts;
+		f64 total_time = 0.0;
+
+		for (const Rebuild_Explanation& explanation : _explanations) {
+
+			++counts[explanation.reason];
+			total_time += explanation.decide_time;
+
+		}
+
+		std::string summary;
+
+		for (const auto& count_it : counts) {
+			summary += (summary.empty() ? "" : ", ") + std::string(reason_to_string(count_it.first)) + ": " + std::to_string(count_it.second);
+		}
+
+		CBUILD_TRACE("Explained {} objects in {:.3f} ms ({})", _explanations.size(), total_time * 1000.0, summary);
+
+	}
+
+	bool Explain::write_json(const std::filesystem::path& _path, const std::vector<Rebuild_Explanation>& _explanations) {
+
+		std::string source = "{\n\t\"objects\": [";
+
+		for (u64 i = 0; i < _explanations.size(); ++i) {
+
+			const Rebuild_Explanation& explanation = _explanations[i];
+
+			source += (i > 0) ? ",\n\t\t{ " : "\n\t\t{ ";
+			source += "\"source\": \"" + Include_Report::escape_json(explanation.source.string()) + "\", ";
+			source += "\"reason\": \"" + std::string(reason_to_string(explanation.reason)) + "\", ";
+			source += "\"detail\": \"" + Include_Report::escape_json(describe(explanation)) + "\", ";
+			source += "\"decide_ms\": " + std::to_string(explanation.decide_time * 1000.0) + ", ";
+			source += "\"chain\": [";
+
+			for (u64 j = 0; j < explanation.chain.size(); ++j) {
+				source += (j > 0 ? ", \"" : "\"") + Include_Report::escape_json(explanation.chain[j].string()) + "\"";
+			}
+
+			source += "] }";
+
+		}
+
+		source += "\n\t]\n}\n";
+
+		return File::write_text_file(_path, source);
+
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "types.h"
+
+namespace CBuild {
+
+	enum class Rebuild_Reason : u8 {
+
+		None, //Up-to-date.
+		Forced,
+		Command_Changed, //The object was compiled with a different command, e.g. other flags, include dirs or compiler.
+		Missing_Object,
+		New_Source,
+		Source_Changed,
+		Header_Changed,
+		Header_Removed,
+		Unresolved_Include, //A computed include couldn't be expanded and there's no depfile to fall back on.
+
+	};
+
+	struct Rebuild_Explanation {
+
+		std::filesystem::path source;
+		Rebuild_Reason reason = Rebuild_Reason::None;
+		std::vector<std::filesystem::path> chain; //Include chain from the source to the file that triggered the rebuild.
+		std::string detail = "";
+		f64 decide_time = 0.0; //Seconds spent deciding, including the wait for scan jobs.
+
+	};
+
+	struct Explain {
+
+		static const char* reason_to_string(Rebuild_Reason _reason);
+		static std::string describe(const Rebuild_Explanation& _explanation);
+		static void print(const Rebuild_Explanation& _explanation);
+		static void print_summary(const std::vector<Rebuild_Explanation>& _explanations);
+		static bool write_json(const std::filesystem::path& _path, const std::vector<Rebuild_Explanation>& _explanations);
+
+	};
+
+}
\ No newline at end of file
@@ -2,6 +2,10 @@
 #include "file.h"
 #include "log.h"
 
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
 namespace CBuild {
 
 	void File::format_path(std::filesystem::path& _path) {
@@ -17,8 +21,9 @@ namespace CBuild {
 
 		String_Helper::trim(path_str);
 
-		if (path_str[0] == (u32)preferred) path_str.erase(0, 1);
-		if (path_str[path_str.length() - 1] == (u32)preferred) path_str.erase(path_str.length() - 1, 1);
+		//A leading separator is the root directory on POSIX systems, keep it there.
+		if (preferred == '\\' && path_str.length() > 0 && path_str[0] == (u32)preferred) path_str.erase(0, 1);
+		if (path_str.length() > 1 && path_str[path_str.length() - 1] == (u32)preferred) path_str.erase(path_str.length() - 1, 1);
 
 		_path = std::filesystem::u8path(path_str);
 
@@ -39,6 +44,40 @@ namespace CBuild {
 		return std::filesystem::is_directory(_path);
 	}
 
+	bool File::get_info(const std::filesystem::path& _path, File_Info& _info) {
+
+		_info = File_Info();
+
+#ifdef _WIN32
+		std::error_code error;
+		std::filesystem::file_status status = std::filesystem::status(_path, error);
+		if (error || !std::filesystem::exists(status)) return false;
+
+		_info.exists = true;
+		_info.is_directory = std::filesystem::is_directory(status);
+
+		std::filesystem::file_time_type write_time = std::filesystem::last_write_time(_path, error);
+		if (!error) _info.time = (u64)write_time.time_since_epoch().count();
+		if (!_info.is_directory) _info.size = (u64)std::filesystem::file_size(_path, error);
+#else
+		//One stat call, where exists, last_write_time and file_size would have needed one each.
+		struct stat st;
+		if (stat(_path.c_str(), &st) != 0) return false;
+
+		_info.exists = true;
+		_info.is_directory = S_ISDIR(st.st_mode);
+		_info.size = (u64)st.st_size;
+#ifdef __APPLE__
+		_info.time = (u64)st.st_mtimespec.tv_sec * 1000000000ull + (u64)st.st_mtimespec.tv_nsec;
+#else
+		_info.time = (u64)st.st_mtim.tv_sec * 1000000000ull + (u64)st.st_mtim.tv_nsec;
+#endif
+#endif
+
+		return true;
+
+	}
+
 	bool File::find_files(const std::filesystem::path& _path, const std::string _extension, std::vector<std::filesystem::path>& _files) {
 
 		if (!directory_exists(_path)) return false;
@@ -10,12 +10,22 @@
 
 namespace CBuild {
 
+	struct File_Info {
+
+		bool exists = false;
+		bool is_directory = false;
+		u64 time = 0; //Last write time, in nanoseconds since the Unix epoch on POSIX systems.
+		u64 size = 0;
+
+	};
+
 	struct File {
 
 		static void format_path(std::filesystem::path& _path);
 		static bool compare(const std::filesystem::path& _path1, const std::filesystem::path& _path2);
 		static bool file_exists(const std::filesystem::path& _path);
 		static bool directory_exists(const std::filesystem::path& _path);
+		static bool get_info(const std::filesystem::path& _path, File_Info& _info);
 		static bool find_files(const std::filesystem::path&, const std::string _extension, std::vector<std::filesystem::path>& _files);
 		static bool read_text_file(const std::filesystem::path&, std::string& _result);
 		static bool write_text_file(const std::filesystem::path&, const std::string& _text);
@@ -0,0 +1,160 @@
+#include "pch.h"
+#include "glob.h"
+#include "file.h"
+
+#include <algorithm>
+
+namespace CBuild {
+
+	std::string Glob::normalize(const std::string& _path) {
+
+		//Patterns and paths are compared with forward slashes and without a leading './'.
+		std::string path = _path;
+		std::replace(path.begin(), path.end(), '\\', '/');
+
+		while (path.compare(0, 2, "./") == 0) path.erase(0, 2);
+
+		return path;
+
+	}
+
+	bool Glob::has_wildcard(const std::string& _segment) {
+		return _segment.find_first_of("*?") != std::string::npos;
+	}
+
+	void Glob::split(const std::string& _path, std::vector<std::string>& _segments) {
+
+		_segments.clear();
+
+		std::string path = normalize(_path);
+		size_t start = 0;
+
+		while (start <= path.length()) {
+
+			size_t end = path.find('/', start);
+			if (end == std::string::npos) end = path.length();
+
+			if (end > start) _segments.push_back(path.substr(start, end - start));
+			else if (start == 0 && end < path.length()) _segments.push_back(""); //Root of an absolute path.
+
+			start = end + 1;
+
+		}
+
+	}
+
+	std::filesystem::path Glob::get_base_dir(const std::string& _pattern) {
+
+		//Everything up to the first segment with a wildcard, which is where the directory walk starts.
+		std::vector<std::string> segments;
+		split(_pattern, segments);
+
+		std::string base = "";
+
+		for (u64 i = 0; i + 1 < segments.size() && !has_wildcard(segments[i]); ++i) {
+
+			if (i > 0) base += "/";
+			base += segments[i];
+
+		}
+
+		if (base.empty() && !segments.empty() && segments[0].empty()) base = "/";
+
+		std::filesystem::path path = std::filesystem::u8path(base);
+		File::format_path(path);
+
+		return path;
+
+	}
+
+	u32 Glob::get_depth(const std::string& _pattern) {
+
+		//How many directories below the base dir can hold a match.
+		std::vector<std::string> segments;
+		split(_pattern, segments);
+
+		u64 base_segments = 0;
+		for (; base_segments + 1 < segments.size() && !has_wildcard(segments[base_segments]); ++base_segments);
+
+		for (u64 i = base_segments; i < segments.size(); ++i) {
+			if (segments[i] == "**") return unlimited_depth;
+		}
+
+		return (u32)(segments.size() - base_segments - 1);
+
+	}
+
+	bool Glob::match(const std::string& _pattern, const std::string& _path) {
+
+		std::vector<std::string> pattern;
+		std::vector<std::string> path;
+
+		split(_pattern, pattern);
+		split(_path, path);
+
+		return match_segments(pattern, 0, path, 0);
+
+	}
+
+	bool Glob::match_segment(const std::string& _pattern, const std::string& _segment) {
+
+		//'*' matches any run of characters and '?' a single one, backtracking to the last '*' on a mismatch.
+		u64 p = 0;
+		u64 s = 0;
+		u64 star = std::string::npos;
+		u64 star_match = 0;
+
+		while (s < _segment.length()) {
+
+			if (p < _pattern.length() && (_pattern[p] == '?' || _pattern[p] == _segment[s])) {
+
+				++p;
+				++s;
+
+			}
+			else if (p < _pattern.length() && _pattern[p] == '*') {
+
+				star = p++;
+				star_match = s;
+
+			}
+			else if (star != std::string::npos) {
+
+				p = star + 1;
+				s = ++star_match;
+
+			}
+			else {
+				return false;
+			}
+
+		}
+
+		while (p < _pattern.length() && _pattern[p] == '*') ++p;
+
+		return p == _pattern.length();
+
+	}
+
+	bool Glob::match_segments(const std::vector<std::string>& _pattern, u64 _pattern_index, const std::vector<std::string>& _path, u64 _path_index) {
+
+		if (_pattern_index >= _pattern.size()) return _path_index >= _path.size();
+
+		//'**' matches any number of directories, including none.
+		if (_pattern[_pattern_index] == "**") {
+
+			for (u64 i = _path_index; i <= _path.size(); ++i) {
+				if (match_segments(_pattern, _pattern_index + 1, _path, i)) return true;
+			}
+
+			return false;
+
+		}
+
+		if (_path_index >= _path.size() || !match_segment(_pattern[_pattern_index], _path[_path_index])) return false;
+
+		return match_segments(_pattern, _pattern_index + 1, _path, _path_index + 1);
+
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "types.h"
+
+namespace CBuild {
+
+	struct Glob {
+
+		static const u32 unlimited_depth = 0xFFFFFFFF;
+
+		static std::string normalize(const std::string& _path);
+		static bool has_wildcard(const std::string& _segment);
+		static void split(const std::string& _path, std::vector<std::string>& _segments);
+		static std::filesystem::path get_base_dir(const std::string& _pattern);
+		static u32 get_depth(const std::string& _pattern);
+		static bool match(const std::string& _pattern, const std::string& _path);
+		static bool match_segment(const std::string& _pattern, const std::string& _segment);
+		static bool match_segments(const std::vector<std::string>& _pattern, u64 _pattern_index, const std::vector<std::string>& _path, u64 _path_index);
+
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include "pch.h"
+#include "hash.h"
+
+#include <string.h>
+
+namespace CBuild {
+
+	static const u64 prime_1 = 11400714785074694791ull;
+	static const u64 prime_2 = 14029467366897019727ull;
+	static const u64 prime_3 = 1609587929392839161ull;
+	static const u64 prime_4 = 9650029242287828579ull;
+	static const u64 prime_5 = 2870177450012600261ull;
+
+	static inline u64 rotate_left(u64 _value, u32 _bits) {
+		return (_value << _bits) | (_value >> (64 - _bits));
+	}
+
+	static inline u64 read_u64(const u8* _data) {
+
+		u64 value;
+		memcpy(&value, _data, sizeof(value));
+
+		return value;
+
+	}
+
+	static inline u32 read_u32(const u8* _data) {
+
+		u32 value;
+		memcpy(&value, _data, sizeof(value));
+
+		return value;
+
+	}
+
+	static inline u64 round(u64 _acc, u64 _input) {
+		return rotate_left(_acc + _input * prime_2, 31) * prime_1;
+	}
+
+	static inline u64 merge_round(u64 _acc, u64 _value) {
+		return (_acc ^ round(0, _value)) * prime_1 + prime_4;
+	}
+
+	u64 Hash::fnv1a(const void* _data, u64 _size, u64 _hash) {
+
+		const u8* data = (const u8*)_data;
+
+		for (u64 i = 0; i < _size; ++i) {
+
+			_hash ^= data[i];
+			_hash *= 1099511628211ull;
+
+		}
+
+		return _hash;
+
+	}
+
+	u64 Hash::xxh64(const void* _data, u64 _size, u64 _seed) {
+
+		//XXH64, four independent lanes per 32 byte stripe, so it runs at memory speed instead of one byte per multiply like FNV-1a.
+		const u8* data = (const u8*)_data;
+		const u8* end = data + _size;
+		u64 hash;
+
+		if (_size >= 32) {
+
+			u64 v1 = _seed + prime_1 + prime_2;
+			u64 v2 = _seed + prime_2;
+			u64 v3 = _seed;
+			u64 v4 = _seed - prime_1;
+
+			for (; data + 32 <= end; data += 32) {
+
+				v1 = round(v1, read_u64(data));
+				v2 = round(v2, read_u64(data + 8));
+				v3 = round(v3, read_u64(data + 16));
+				v4 = round(v4, read_u64(data + 24));
+
+			}
+
+			hash = rotate_left(v1, 1) + rotate_left(v2, 7) + rotate_left(v3, 12) + rotate_left(v4, 18);
+			hash = merge_round(hash, v1);
+			hash = merge_round(hash, v2);
+			hash = merge_round(hash, v3);
+			hash = merge_round(hash, v4);
+
+		}
+		else {
+			hash = _seed + prime_5;
+		}
+
+		hash += _size;
+
+		for (; data + 8 <= end; data += 8) {
+			hash = rotate_left(hash ^ round(0, read_u64(data)), 27) * prime_1 + prime_4;
+		}
+
+		if (data + 4 <= end) {
+
+			hash = rotate_left(hash ^ (read_u32(data) * prime_1), 23) * prime_2 + prime_3;
+			data += 4;
+
+		}
+
+		for (; data < end; ++data) {
+			hash = rotate_left(hash ^ (*data * prime_5), 11) * prime_1;
+		}
+
+		hash ^= hash >> 33;
+		hash *= prime_2;
+		hash ^= hash >> 29;
+		hash *= prime_3;
+		hash ^= hash >> 32;
+
+		return hash;
+
+	}
+
+	u64 Hash::string(const std::string& _str, u64 _hash) {
+		return fnv1a(_str.data(), _str.length(), _hash);
+	}
+
+	u64 Hash::combine(u64 _hash, u64 _value) {
+		return fnv1a(&_value, sizeof(_value), _hash);
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+#include "types.h"
+
+namespace CBuild {
+
+	struct Hash {
+
+		static const u64 seed = 14695981039346656037ull;
+
+		static u64 fnv1a(const void* _data, u64 _size, u64 _hash = seed);
+		static u64 xxh64(const void* _data, u64 _size, u64 _seed = 0);
+		static u64 string(const std::string& _str, u64 _hash = seed);
+		static u64 combine(u64 _hash, u64 _value);
+
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include "pch.h"
+#include "include_graph.h"
+
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace CBuild {
+
+	static inline u32 count_trailing_zeros(u64 _mask) {
+
+#ifdef _MSC_VER
+		unsigned long index = 0;
+		_BitScanForward64(&index, _mask);
+		return (u32)index;
+#else
+		return (u32)__builtin_ctzll(_mask);
+#endif
+
+	}
+
+	void Include_Graph::find_components() {
+
+		//Tarjan's algorithm with an explicit call stack, so long include chains can't overflow the real one.
+		//Files that include each other end up in the same component, and components are numbered in reverse topological order.
+		constexpr u32 unvisited = 0xFFFFFFFF;
+
+		u64 count = edges.size();
+
+		std::vector<u32> indices(count, unvisited);
+		std::vector<u32> low_links(count, 0);
+		std::vector<bool> on_stack(count, false);
+		std::vector<Path_ID> stack;
+		std::vector<std::pair<Path_ID, u32>> calls; //File and the next edge to follow.
+
+		components.assign(count, 0);
+		component_count = 0;
+
+		u32 next_index = 0;
+
+		for (Path_ID root = 0; root < count; ++root) {
+
+			if (indices[root] != unvisited) continue;
+
+			indices[root] = low_links[root] = next_index++;
+			stack.push_back(root);
+			on_stack[root] = true;
+			calls.emplace_back(root, 0);
+
+			while (!calls.empty()) {
+
+				Path_ID id = calls.back().first;
+				u32& edge = calls.back().second;
+
+				if (edge < edges[id].size()) {
+
+					Path_ID include = edges[id][edge++];
+					if (include >= count) continue;
+
+					if (indices[include] == unvisited) {
+
+						indices[include] = low_links[include] = next_index++;
+						stack.push_back(include);
+						on_stack[include] = true;
+						calls.emplace_back(include, 0);
+
+					}
+					else if (on_stack[include]) {
+						low_links[id] = std::min(low_links[id], indices[include]);
+					}
+
+					continue;
+
+				}
+
+				calls.pop_back();
+				if (!calls.empty()) low_links[calls.back().first] = std::min(low_links[calls.back().first], low_links[id]);
+
+				if (low_links[id] != indices[id]) continue;
+
+				Path_ID member = 0;
+
+				do {
+
+					member = stack.back();
+					stack.pop_back();
+
+					on_stack[member] = false;
+					components[member] = component_count;
+
+				} while (member != id);
+
+				++component_count;
+
+			}
+
+		}
+
+	}
+
+	void Include_Graph::get_closure_sizes(const std::vector<u64>& _sizes, std::vector<u64>& _closure) {
+
+		//Sums the sizes of every file reachable from each file, counting shared headers once.
+		//Reachability is a bitset per component, filled in topological order so each component is evaluated once.
+		//To keep memory bounded, the bitsets only cover a block of target components at a time.
+		find_components();
+
+		std::vector<u64> component_sizes(component_count, 0);
+		std::vector<std::vector<u32>> successors(component_count);
+
+		for (Path_ID id = 0; id < edges.size(); ++id) {
+
+			if (id < _sizes.size()) component_sizes[components[id]] += _sizes[id];
+
+			for (Path_ID include : edges[id]) {
+				if (include < edges.size() && components[include] != components[id]) successors[components[id]].push_back(components[include]);
+			}
+
+		}
+
+		constexpr u32 block_words = 64;
+		constexpr u32 block_size = block_words * 64;
+
+		std::vector<u64> closure(component_count, 0);
+		std::vector<u64> bits;
+
+		for (u32 block = 0; block < component_count; block += block_size) {
+
+			//Components only reach components with a lower number, so the ones below the block can't reach into it.
+			u32 block_end = std::min<u32>(block + block_size, component_count);
+			bits.assign((u64)(component_count - block) * block_words, 0);
+
+			for (u32 component = block; component < component_count; ++component) {
+
+				u64* reach = &bits[(u64)(component - block) * block_words];
+				if (component < block_end) reach[(component - block) / 64] |= 1ull << ((component - block) % 64);
+
+				for (u32 successor : successors[component]) {
+
+					if (successor < block) continue;
+
+					const u64* successor_reach = &bits[(u64)(successor - block) * block_words];
+					for (u32 i = 0; i < block_words; ++i) reach[i] |= successor_reach[i];
+
+				}
+
+				for (u32 i = 0; i < block_words; ++i) {
+
+					for (u64 word = reach[i]; word != 0; word &= word - 1) {
+						closure[component] += component_sizes[block + i * 64 + count_trailing_zeros(word)];
+					}
+
+				}
+
+			}
+
+		}
+
+		_closure.assign(edges.size(), 0);
+
+		for (Path_ID id = 0; id < edges.size(); ++id) {
+			_closure[id] = closure[components[id]];
+		}
+
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <vector>
+
+#include "types.h"
+#include "path_table.h"
+
+namespace CBuild {
+
+	struct Include_Graph {
+
+		std::vector<std::vector<Path_ID>> edges; //Indexed by path ID, the files each file includes.
+		std::vector<u32> components; //Strongly connected component of each file, every component comes after the ones it reaches.
+		u32 component_count = 0;
+
+		void find_components();
+		void get_closure_sizes(const std::vector<u64>& _sizes, std::vector<u64>& _closure);
+
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,212 @@
+#include "pch.h"
+#include "include_report.h"
+#include "include_graph.h"
+#include "parser.h"
+#include "dependency_scanner.h"
+
+#include <algorithm>
+
+namespace CBuild {
+
+	bool Include_Report::run(Parser& _parser, Config_Type _config_type, u32 _job_count) {
+
+		std::vector<std::filesystem::path> source_files;
+		if (!_parser.find_source_files(source_files)) return false;
+
+		//Every source is scanned, the depfiles don't have the edges between headers.
+		Dependency_Scanner scanner(_parser, _config_type, _parser.compiler, _job_count);
+		scanner.use_depfiles = false;
+
+		std::vector<Path_ID> sources;
+		std::vector<bool> is_source;
+
+		for (const std::filesystem::path& file : source_files) {
+
+			Path_ID id = scanner.add_file(file, true);
+			sources.push_back(id);
+
+			if (is_source.size() <= id) is_source.resize(id + 1, false);
+			is_source[id] = true;
+
+		}
+
+		//Fan-in follows the conditionals, so a header behind '#ifdef _WIN32' doesn't count on other platforms.
+		std::vector<u64> fan_in;
+
+		for (Path_ID source : sources) {
+
+			Walk_State state;
+			state.preprocessor = scanner.predefined;
+			state.stop_on_change = false;
+
+			scanner.walk(source, Region::Live, true, state);
+
+			if (fan_in.size() < state.entered.size()) fan_in.resize(state.entered.size(), 0);
+
+			for (Path_ID id = 0; id < state.entered.size(); ++id) {
+				if (state.entered[id] && (id >= is_source.size() || !is_source[id])) ++fan_in[id];
+			}
+
+		}
+
+		scanner.wait();
+
+		std::vector<u64> sizes(scanner.files.size(), 0);
+
+		for (const Checked_File& file : scanner.files) {
+
+			std::error_code error;
+			if (file.added && file.exists) sizes[file.id] = (u64)std::filesystem::file_size(file.path, error);
+
+		}
+
+		//Closure bytes count every branch, a header's own conditionals depend on who includes it.
+		//Headers that include each other share a closure, so the graph is condensed and every component is summed once.
+		Include_Graph graph;
+		graph.edges.resize(scanner.files.size());
+
+		for (const Checked_File& file : scanner.files) {
+			if (file.includes != nullptr) graph.edges[file.id] = file.includes->includes;
+		}
+
+		std::vector<u64> closure_bytes;
+		graph.get_closure_sizes(sizes, closure_bytes);
+
+		std::vector<Header_Cost> headers;
+
+		for (Path_ID id = 0; id < fan_in.size(); ++id) {
+
+			if (fan_in[id] <= 0) continue;
+
+			Header_Cost& header = headers.emplace_back();
+			header.id = id;
+			header.size = sizes[id];
+			header.fan_in = fan_in[id];
+			header.closure_bytes = closure_bytes[id];
+			header.cost = header.fan_in * header.closure_bytes;
+
+		}
+
+		std::sort(headers.begin(), headers.end(), [](const Header_Cost& _a, const Header_Cost& _b) { return (_a.cost != _b.cost) ? _a.cost > _b.cost : _a.fan_in > _b.fan_in; });
+
+		CBUILD_TRACE("{} sources, {} headers.", sources.size(), headers.size());
+		CBUILD_TRACE("{:>14} {:>8} {:>12} {:>10}  {}", "Cost (bytes)", "Fan-in", "Closure", "Size", "Header");
+
+		for (const Header_Cost& header : headers) {
+			CBUILD_TRACE("{:>14} {:>8} {:>12} {:>10}  {}", header.cost, header.fan_in, header.closure_bytes, header.size, scanner.files[header.id].path.string());
+		}
+
+		std::filesystem::path output_path = _parser.get_obj_output_path(_config_type);
+
+		std::error_code error;
+		std::filesystem::create_directories(output_path, error);
+
+		std::filesystem::path json_path = output_path / "include_report.json";
+		std::filesystem::path dot_path = output_path / "include_report.dot";
+		File::format_path(json_path);
+		File::format_path(dot_path);
+
+		if (!write_json(json_path, scanner, headers, sources) || !write_dot(dot_path, scanner, headers, sources)) {
+
+			CBUILD_ERROR("Error writing include report to '{}'.", output_path.string());
+			return false;
+
+		}
+
+		CBUILD_INFO("Generated '{}'", json_path.string());
+		CBUILD_INFO("Generated '{}'", dot_path.string());
+
+		return true;
+
+	}
+
+	std::string Include_Report::escape_json(const std::string& _str) {
+
+		std::string result;
+
+		for (char c : _str) {
+
+			if (c == '"' || c == '\\') result += '\\';
+			result += c;
+
+		}
+
+		return result;
+
+	}
+
+	bool Include_Report::write_json(const std::filesystem::path& _path, Dependency_Scanner& _scanner, const std::vector<Header_Cost>& _headers, const std::vector<Path_ID>& _sources) {
+
+		std::string source = "{\n\t\"sources\": " + std::to_string(_sources.size()) + ",\n\t\"headers\": [";
+
+		for (u64 i = 0; i < _headers.size(); ++i) {
+
+			const Header_Cost& header = _headers[i];
+			const Checked_File& file = _scanner.files[header.id];
+
+			source += (i > 0) ? ",\n\t\t{ " : "\n\t\t{ ";
+			source += "\"file\": \"" + escape_json(file.path.string()) + "\", ";
+			source += "\"size\": " + std::to_string(header.size) + ", ";
+			source += "\"fan_in\": " + std::to_string(header.fan_in) + ", ";
+			source += "\"closure_bytes\": " + std::to_string(header.closure_bytes) + ", ";
+			source += "\"cost\": " + std::to_string(header.cost) + ", ";
+			source += "\"includes\": [";
+
+			if (file.includes != nullptr) {
+
+				for (u64 j = 0; j < file.includes->includes.size(); ++j) {
+
+					if (j > 0) source += ", ";
+					source += "\"" + escape_json(_scanner.files[file.includes->includes[j]].path.string()) + "\"";
+
+				}
+
+			}
+
+			source += "] }";
+
+		}
+
+		source += "\n\t]\n}\n";
+
+		return File::write_text_file(_path, source);
+
+	}
+
+	bool Include_Report::write_dot(const std::filesystem::path& _path, Dependency_Scanner& _scanner, const std::vector<Header_Cost>& _headers, const std::vector<Path_ID>& _sources) {
+
+		std::string source = "digraph includes {\n\tnode [shape=box];\n";
+		std::vector<bool> reported(_scanner.files.size(), false);
+
+		for (Path_ID id : _sources) {
+
+			reported[id] = true;
+			source += "\tn" + std::to_string(id) + " [label=\"" + escape_json(_scanner.files[id].path.string()) + "\", style=filled, fillcolor=lightgrey];\n";
+
+		}
+
+		for (const Header_Cost& header : _headers) {
+
+			reported[header.id] = true;
+			source += "\tn" + std::to_string(header.id) + " [label=\"" + escape_json(_scanner.files[header.id].path.string()) + "\\nfan-in " + std::to_string(header.fan_in) + ", " + std::to_string(header.closure_bytes) + " bytes\"];\n";
+
+		}
+
+		for (Path_ID id = 0; id < reported.size(); ++id) {
+
+			const std::shared_ptr<const File_Includes>& includes = _scanner.files[id].includes;
+			if (!reported[id] || includes == nullptr) continue;
+
+			for (Path_ID include : includes->includes) {
+				if (reported[include]) source += "\tn" + std::to_string(id) + " -> n" + std::to_string(include) + ";\n";
+			}
+
+		}
+
+		source += "}\n";
+
+		return File::write_text_file(_path, source);
+
+	}
+
+}
\ No newline at end of file
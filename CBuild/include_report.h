@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "types.h"
+#include "config.h"
+#include "path_table.h"
+
+namespace CBuild {
+
+	struct Parser;
+	struct Dependency_Scanner;
+
+	struct Header_Cost {
+
+		Path_ID id = 0;
+		u64 size = 0;
+		u64 fan_in = 0; //Translation units that reach the header.
+		u64 closure_bytes = 0; //The header and everything it includes.
+		u64 cost = 0; //Bytes preprocessed because of the header over a full build.
+
+	};
+
+	struct Include_Report {
+
+		static bool run(Parser& _parser, Config_Type _config_type, u32 _job_count);
+		static std::string escape_json(const std::string& _str);
+		static bool write_json(const std::filesystem::path& _path, Dependency_Scanner& _scanner, const std::vector<Header_Cost>& _headers, const std::vector<Path_ID>& _sources);
+		static bool write_dot(const std::filesystem::path& _path, Dependency_Scanner& _scanner, const std::vector<Header_Cost>& _headers, const std::vector<Path_ID>& _sources);
+
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,489 @@
+#include "pch.h"
+#include "include_scanner.h"
+#include "string_helper.h"
+
+#include <string.h>
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CBUILD_SCAN_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CBUILD_SCAN_SSE2
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace CBuild {
+
+	static inline u32 count_trailing_zeros(u32 _mask) {
+
+#ifdef _MSC_VER
+		unsigned long index = 0;
+		_BitScanForward(&index, _mask);
+		return (u32)index;
+#else
+		return (u32)__builtin_ctz(_mask);
+#endif
+
+	}
+
+	static inline bool is_space(char _char) {
+		return (_char == ' ' || _char == '\t' || _char == '\r' || _char == '\v' || _char == '\f');
+	}
+
+	static inline bool is_identifier_char(char _char) {
+		return (_char == '_') || (_char >= '0' && _char <= '9') || (_char >= 'A' && _char <= 'Z') || (_char >= 'a' && _char <= 'z');
+	}
+
+	size_t Include_Scanner::find_special_char(const char* _data, size_t _index, size_t _length) {
+
+		//Everything but directives, comments and literals is skipped, so only '#', '/', '"' and '\'' need to be found.
+#if defined(CBUILD_SCAN_AVX2)
+
+		const __m256i hash = _mm256_set1_epi8('#');
+		const __m256i slash = _mm256_set1_epi8('/');
+		const __m256i quote = _mm256_set1_epi8('"');
+		const __m256i apostrophe = _mm256_set1_epi8('\'');
+
+		for (; _index + 32 <= _length; _index += 32) {
+
+			__m256i chunk = _mm256_loadu_si256((const __m256i*)(_data + _index));
+			__m256i match = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, hash), _mm256_cmpeq_epi8(chunk, slash)), _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, apostrophe)));
+
+			u32 mask = (u32)_mm256_movemask_epi8(match);
+			if (mask != 0) return _index + count_trailing_zeros(mask);
+
+		}
+
+#elif defined(CBUILD_SCAN_SSE2)
+
+		const __m128i hash = _mm_set1_epi8('#');
+		const __m128i slash = _mm_set1_epi8('/');
+		const __m128i quote = _mm_set1_epi8('"');
+		const __m128i apostrophe = _mm_set1_epi8('\'');
+
+		for (; _index + 16 <= _length; _index += 16) {
+
+			__m128i chunk = _mm_loadu_si128((const __m128i*)(_data + _index));
+			__m128i match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, hash), _mm_cmpeq_epi8(chunk, slash)), _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, apostrophe)));
+
+			u32 mask = (u32)_mm_movemask_epi8(match);
+			if (mask != 0) return _index + count_trailing_zeros(mask);
+
+		}
+
+#endif
+
+		for (; _index < _length; ++_index) {
+
+			char cur = _data[_index];
+			if (cur == '#' || cur == '/' || cur == '"' || cur == '\'') return _index;
+
+		}
+
+		return _length;
+
+	}
+
+	bool Include_Scanner::is_line_start(const char* _data, size_t _index, size_t _comment_start, size_t _comment_end) {
+
+		//Walk back over whitespace, and over the last block comment if it sits between the line start and the '#'.
+		while (_index > 0) {
+
+			if (_index == _comment_end && _comment_end > _comment_start) {
+
+				_index = _comment_start;
+				continue;
+
+			}
+
+			char prev = _data[_index - 1];
+
+			if (prev == '\n') {
+
+				//A line continuation joins this line with the previous one.
+				if (_index >= 2 && _data[_index - 2] == '\\') return false;
+				if (_index >= 3 && _data[_index - 2] == '\r' && _data[_index - 3] == '\\') return false;
+
+				return true;
+
+			}
+
+			if (!is_space(prev)) return false;
+			--_index;
+
+		}
+
+		return true;
+
+	}
+
+	static inline bool is_line_splice(const char* _data, size_t _index, size_t _length) {
+		return _data[_index] == '\\' && ((_index + 1 < _length && _data[_index + 1] == '\n') || (_index + 2 < _length && _data[_index + 1] == '\r' && _data[_index + 2] == '\n'));
+	}
+
+	static inline bool is_name(const char* _data, size_t _start, size_t _length, const char* _name) {
+		return _length == strlen(_name) && memcmp(_data + _start, _name, _length) == 0;
+	}
+
+	size_t Include_Scanner::read_line(const char* _data, size_t _index, size_t _length, std::string& _text) {
+
+		//Reads the rest of a directive, joining continued lines and dropping comments.
+		_text.clear();
+
+		while (_index < _length) {
+
+			char cur = _data[_index];
+			char next = (_index + 1 < _length) ? _data[_index + 1] : '\0';
+
+			if (is_line_splice(_data, _index, _length)) {
+
+				_index += (_data[_index + 1] == '\r') ? 3 : 2;
+				continue;
+
+			}
+
+			if (cur == '\n') break;
+
+			if (cur == '/' && next == '/') {
+
+				for (; _index < _length && _data[_index] != '\n'; ++_index) {
+					if (is_line_splice(_data, _index, _length)) _index += (_data[_index + 1] == '\r') ? 2 : 1;
+				}
+
+				break;
+
+			}
+
+			if (cur == '/' && next == '*') {
+
+				const char* end = nullptr;
+				bool terminated = false;
+
+				for (_index += 2; _index < _length; _index = (size_t)(end - _data) + 1) {
+
+					end = (const char*)memchr(_data + _index, '*', _length - _index);
+					if (end == nullptr) break;
+
+					if ((size_t)(end - _data) + 1 < _length && end[1] == '/') {
+
+						terminated = true;
+						break;
+
+					}
+
+				}
+
+				//An unterminated comment runs to the end of the file.
+				_index = terminated ? (size_t)(end - _data) + 2 : _length;
+				_text += ' ';
+
+				continue;
+
+			}
+
+			if (cur == '"' || cur == '\'') {
+
+				//Continued lines inside a literal are joined as well, the newline isn't part of the directive.
+				bool escaped = false;
+				_text += cur;
+
+				for (++_index; _index < _length; ++_index) {
+
+					if (is_line_splice(_data, _index, _length)) {
+
+						_index += (_data[_index + 1] == '\r') ? 2 : 1;
+						continue;
+
+					}
+
+					char c = _data[_index];
+					if (c == '\n') break;
+
+					_text += c;
+
+					if (escaped) escaped = false;
+					else if (c == '\\') escaped = true;
+					else if (c == cur) {
+
+						++_index;
+						break;
+
+					}
+
+				}
+
+				continue;
+
+			}
+
+			_text += is_space(cur) ? ' ' : cur;
+			++_index;
+
+		}
+
+		String_Helper::trim(_text);
+		return _index;
+
+	}
+
+	void Include_Scanner::scan(const std::string& _source, std::vector<Directive>& _directives) {
+
+		_directives.clear();
+
+		const char* data = _source.data();
+		size_t length = _source.length();
+
+		size_t comment_start = 0;
+		size_t comment_end = 0;
+
+		std::string text;
+
+		size_t i = 0;
+
+		while (true) {
+
+			i = find_special_char(data, i, length);
+			if (i >= length) return;
+
+			char cur = data[i];
+			char next = (i + 1 < length) ? data[i + 1] : '\0';
+
+			//Single line comment.
+			if (cur == '/' && next == '/') {
+
+				while (true) {
+
+					const char* end = (const char*)memchr(data + i, '\n', length - i);
+					if (end == nullptr) return;
+
+					i = (size_t)(end - data) + 1;
+					if (i >= 2 && data[i - 2] != '\\' && !(i >= 3 && data[i - 2] == '\r' && data[i - 3] == '\\')) break;
+
+				}
+
+				continue;
+
+			}
+
+			//Multi line comment.
+			if (cur == '/' && next == '*') {
+
+				comment_start = i;
+				i += 2;
+
+				while (true) {
+
+					const char* end = (const char*)memchr(data + i, '*', length - i);
+					if (end == nullptr) return;
+
+					i = (size_t)(end - data) + 1;
+					if (i < length && data[i] == '/') break;
+
+				}
+
+				++i;
+				comment_end = i;
+
+				continue;
+
+			}
+
+			//String and character literals.
+			if (cur == '"' || cur == '\'') {
+
+				for (++i; i < length; ++i) {
+
+					if (data[i] == '\\') ++i;
+					else if (data[i] == cur || data[i] == '\n') break;
+
+				}
+
+				++i;
+				continue;
+
+			}
+
+			if (cur != '#' || !is_line_start(data, i, comment_start, comment_end)) {
+
+				++i;
+				continue;
+
+			}
+
+			//Directive.
+			for (++i; i < length && is_space(data[i]); ++i);
+
+			size_t name_start = i;
+			for (; i < length && is_identifier_char(data[i]); ++i);
+
+			size_t name_length = i - name_start;
+			if (name_length < 2) continue;
+
+			if (is_name(data, name_start, name_length, "include") || is_name(data, name_start, name_length, "include_next")) {
+
+				for (; i < length && is_space(data[i]); ++i);
+				if (i >= length) return;
+
+				char open = data[i];
+
+				//#include MACRO, which can only be resolved once the macros of the translation unit are known.
+				if (open != '"' && open != '<') {
+
+					if (!is_identifier_char(open)) continue;
+
+					Directive& directive = _directives.emplace_back();
+					i = read_line(data, i, length, directive.name);
+					directive.computed = true;
+
+					continue;
+
+				}
+
+				char close = (open == '<') ? '>' : '"';
+				size_t file_start = ++i;
+
+				for (; i < length && data[i] != close && data[i] != '\n'; ++i);
+				if (i >= length || data[i] != close) continue;
+
+				Directive& directive = _directives.emplace_back();
+				directive.name = std::string(data + file_start, i - file_start);
+				directive.angled = (open == '<');
+
+				++i;
+				continue;
+
+			}
+
+			if (is_name(data, name_start, name_length, "pragma")) {
+
+				i = read_line(data, i, length, text);
+				if (text == "once") _directives.emplace_back().type = Directive_Type::Pragma_Once;
+
+				continue;
+
+			}
+
+			//Conditionals and macro definitions, these decide which of the includes are actually reached.
+			Directive directive;
+
+			if (is_name(data, name_start, name_length, "if")) directive.type = Directive_Type::If;
+			else if (is_name(data, name_start, name_length, "ifdef")) directive.type = Directive_Type::Ifdef;
+			else if (is_name(data, name_start, name_length, "ifndef")) directive.type = Directive_Type::Ifndef;
+			else if (is_name(data, name_start, name_length, "elif")) directive.type = Directive_Type::Elif;
+			else if (is_name(data, name_start, name_length, "elifdef")) directive.type = Directive_Type::Elif;
+			else if (is_name(data, name_start, name_length, "elifndef")) directive.type = Directive_Type::Elif;
+			else if (is_name(data, name_start, name_length, "else")) directive.type = Directive_Type::Else;
+			else if (is_name(data, name_start, name_length, "endif")) directive.type = Directive_Type::Endif;
+			else if (is_name(data, name_start, name_length, "define")) directive.type = Directive_Type::Define;
+			else if (is_name(data, name_start, name_length, "undef")) directive.type = Directive_Type::Undef;
+			else continue;
+
+			bool elifdef = is_name(data, name_start, name_length, "elifdef");
+			bool elifndef = is_name(data, name_start, name_length, "elifndef");
+
+			if (directive.type == Directive_Type::Define || directive.type == Directive_Type::Undef || directive.type == Directive_Type::Ifdef || directive.type == Directive_Type::Ifndef) {
+
+				for (; i < length && is_space(data[i]); ++i);
+
+				size_t macro_start = i;
+				for (; i < length && is_identifier_char(data[i]); ++i);
+
+				directive.name = std::string(data + macro_start, i - macro_start);
+
+				//Parameters are never needed, invoking a function-like macro in a condition can't be evaluated anyway.
+				if (directive.type == Directive_Type::Define && i < length && data[i] == '(') {
+
+					directive.function_like = true;
+					for (; i < length && data[i] != ')' && data[i] != '\n'; ++i);
+					if (i < length && data[i] == ')') ++i;
+
+				}
+
+			}
+
+			i = read_line(data, i, length, text);
+
+			if (directive.type == Directive_Type::Define) directive.value = text;
+			else if (elifdef) directive.name = "defined " + text;
+			else if (elifndef) directive.name = "!defined " + text;
+			else if (directive.type == Directive_Type::If || directive.type == Directive_Type::Elif) directive.name = text;
+
+			//A #define or #undef without a macro name is malformed, there is nothing to record.
+			if ((directive.type == Directive_Type::Define || directive.type == Directive_Type::Undef) && directive.name.empty()) continue;
+
+			_directives.push_back(directive);
+
+		}
+
+	}
+
+	std::string Include_Scanner::find_guard(const std::vector<Directive>& _directives) {
+
+		//Matches '#ifndef X' or '#if !defined(X)', then '#define X', with the matching '#endif' as the last directive.
+		size_t first = 0;
+		size_t last = _directives.size();
+
+		for (; first < last && _directives[first].type == Directive_Type::Pragma_Once; ++first);
+		for (; last > first && _directives[last - 1].type == Directive_Type::Pragma_Once; --last);
+
+		if (last - first < 3) return "";
+
+		const Directive& start = _directives[first];
+		std::string guard = "";
+
+		if (start.type == Directive_Type::Ifndef) {
+			guard = start.name;
+		}
+		else if (start.type == Directive_Type::If) {
+
+			std::string expression = "";
+
+			for (char c : start.name) {
+				if (!is_space(c)) expression += c;
+			}
+
+			if (expression.compare(0, 8, "!defined") != 0) return "";
+
+			expression.erase(0, 8);
+			if (expression.length() >= 2 && expression.front() == '(' && expression.back() == ')') expression = expression.substr(1, expression.length() - 2);
+
+			if (expression.empty() || !std::all_of(expression.begin(), expression.end(), is_identifier_char)) return "";
+
+			guard = expression;
+
+		}
+
+		if (guard.empty()) return "";
+
+		const Directive& define = _directives[first + 1];
+		if (define.type != Directive_Type::Define || define.name != guard || define.function_like) return "";
+
+		//Nothing but the guard's own '#endif' may close it, and it can't have an '#else' either.
+		u32 depth = 1;
+
+		for (size_t i = first + 2; i < last; ++i) {
+
+			switch (_directives[i].type) {
+
+				case Directive_Type::If:
+				case Directive_Type::Ifdef:
+				case Directive_Type::Ifndef: ++depth; break;
+				case Directive_Type::Elif:
+				case Directive_Type::Else: if (depth == 1) return ""; break;
+				case Directive_Type::Endif: if (--depth == 0 && i + 1 < last) return ""; break;
+				default: break;
+
+			}
+
+		}
+
+		return (depth == 0) ? guard : "";
+
+	}
+
+}
\ No newline at end of file
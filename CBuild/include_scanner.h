@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+namespace CBuild {
+
+	enum class Directive_Type : u8 {
+
+		Include,
+		Define,
+		Undef,
+		If,
+		Ifdef,
+		Ifndef,
+		Elif,
+		Else,
+		Endif,
+		Pragma_Once,
+
+	};
+
+	struct Directive {
+
+		Directive_Type type = Directive_Type::Include;
+		std::string name = ""; //Included file, macro name or #if/#elif expression.
+		std::string value = ""; //Replacement list of a #define.
+		bool angled = false; //#include <...> instead of #include "...".
+		bool computed = false; //#include MACRO, the name holds the unexpanded text.
+		bool function_like = false; //#define NAME(...)
+
+	};
+
+	struct Include_Scanner {
+
+		static void scan(const std::string& _source, std::vector<Directive>& _directives);
+		static size_t find_special_char(const char* _data, size_t _index, size_t _length);
+		static bool is_line_start(const char* _data, size_t _index, size_t _comment_start, size_t _comment_end);
+		static size_t read_line(const char* _data, size_t _index, size_t _length, std::string& _text);
+		static std::string find_guard(const std::vector<Directive>& _directives);
+
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,224 @@
+#include "pch.h"
+#include "job_pool.h"
+#include "file.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#elif defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace CBuild {
+
+	Job_Pool::Job_Pool(u32 _job_count) {
+
+		if (_job_count <= 0) _job_count = get_default_job_count();
+
+		for (u32 i = 0; i < _job_count; ++i) {
+			workers.emplace_back(&Job_Pool::worker_loop, this);
+		}
+
+	}
+
+	Job_Pool::~Job_Pool() {
+
+		wait();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+
+		job_condition.notify_all();
+
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+
+	}
+
+	u32 Job_Pool::get_default_job_count() {
+
+		u32 count = std::thread::hardware_concurrency();
+
+#ifdef _WIN32
+
+		DWORD_PTR process_mask = 0;
+		DWORD_PTR system_mask = 0;
+
+		if (GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask)) {
+
+			u32 affinity_count = 0;
+			for (; process_mask != 0; process_mask &= process_mask - 1) ++affinity_count;
+
+			if (affinity_count > 0 && (count <= 0 || affinity_count < count)) count = affinity_count;
+
+		}
+
+#elif defined(__linux__)
+
+		//Respect the CPU affinity mask (taskset, cpusets).
+		cpu_set_t cpu_set;
+		if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0) {
+
+			u32 affinity_count = (u32)CPU_COUNT(&cpu_set);
+			if (affinity_count > 0 && (count <= 0 || affinity_count < count)) count = affinity_count;
+
+		}
+
+		//Respect cgroup CPU quotas (containers). cgroup v2 exposes 'cpu.max' as "<quota> <period>",
+		//cgroup v1 splits it into 'cpu.cfs_quota_us' and 'cpu.cfs_period_us'.
+		s64 quota = -1;
+		s64 period = 0;
+
+		std::string source;
+		std::string cgroup_path = "";
+
+		if (File::read_text_file("/proc/self/cgroup", source)) {
+
+			std::stringstream stream(source);
+			std::string line;
+
+			while (std::getline(stream, line)) {
+
+				if (line.rfind("0::", 0) == 0) {
+
+					cgroup_path = line.substr(3);
+					break;
+
+				}
+
+			}
+
+		}
+
+		if (File::read_text_file("/sys/fs/cgroup" + cgroup_path + "/cpu.max", source) || File::read_text_file("/sys/fs/cgroup/cpu.max", source)) {
+
+			std::stringstream stream(source);
+			std::string quota_str;
+
+			stream >> quota_str >> period;
+			if (quota_str != "max") quota = std::atoll(quota_str.c_str());
+
+		}
+		else {
+
+			std::string period_source;
+
+			if (File::read_text_file("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", source) && File::read_text_file("/sys/fs/cgroup/cpu/cpu.cfs_period_us", period_source)) {
+
+				quota = std::atoll(source.c_str());
+				period = std::atoll(period_source.c_str());
+
+			}
+
+		}
+
+		if (quota > 0 && period > 0) {
+
+			u32 quota_count = (u32)((quota + period - 1) / period);
+			if (quota_count > 0 && (count <= 0 || quota_count < count)) count = quota_count;
+
+		}
+
+#endif
+
+		return (count > 0) ? count : 1;
+
+	}
+
+	u64 Job_Pool::submit(const std::string& _name, std::function<bool()> _callback) {
+
+		u64 index = 0;
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			index = jobs.size();
+			jobs.push_back({ _name, _callback, Job_State::Pending });
+
+			queue.push_back(index);
+			++active_jobs;
+		}
+
+		job_condition.notify_one();
+
+		return index;
+
+	}
+
+	bool Job_Pool::wait() {
+
+		std::unique_lock<std::mutex> lock(mutex);
+		done_condition.wait(lock, [this]() { return active_jobs <= 0; });
+
+		return !failed;
+
+	}
+
+	bool Job_Pool::has_failed() {
+
+		std::lock_guard<std::mutex> lock(mutex);
+		return failed;
+
+	}
+
+	const Job* Job_Pool::get_first_failed_job() {
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		//Jobs are stored in submission order, so the reported failure does not depend on scheduling.
+		for (const Job& job : jobs) {
+			if (job.state == Job_State::Failed) return &job;
+		}
+
+		return nullptr;
+
+	}
+
+	void Job_Pool::worker_loop() {
+
+		std::unique_lock<std::mutex> lock(mutex);
+
+		while (true) {
+
+			job_condition.wait(lock, [this]() { return stopping || !queue.empty(); });
+
+			if (queue.empty()) {
+
+				if (stopping) return;
+				continue;
+
+			}
+
+			u64 index = queue.front();
+			queue.pop_front();
+
+			Job& job = jobs[index];
+
+			//Once a job has failed, drain the queue without starting anything new.
+			if (failed) {
+				job.state = Job_State::Cancelled;
+			}
+			else {
+
+				job.state = Job_State::Running;
+				std::function<bool()> callback = job.callback;
+
+				lock.unlock();
+				bool success = callback();
+				lock.lock();
+
+				job.state = success ? Job_State::Succeeded : Job_State::Failed;
+				if (!success) failed = true;
+
+			}
+
+			--active_jobs;
+			if (active_jobs <= 0) done_condition.notify_all();
+
+		}
+
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include "types.h"
+
+namespace CBuild {
+
+	enum class Job_State : u8 {
+
+		Pending,
+		Running,
+		Succeeded,
+		Failed,
+		Cancelled,
+
+	};
+
+	struct Job {
+
+		std::string name = "";
+		std::function<bool()> callback;
+		Job_State state = Job_State::Pending;
+
+	};
+
+	struct Job_Pool {
+
+		std::vector<std::thread> workers;
+		std::deque<Job> jobs;
+		std::deque<u64> queue;
+
+		std::mutex mutex;
+		std::condition_variable job_condition;
+		std::condition_variable done_condition;
+
+		u64 active_jobs = 0;
+		bool failed = false;
+		bool stopping = false;
+
+		Job_Pool(u32 _job_count);
+		~Job_Pool();
+
+		static u32 get_default_job_count();
+
+		u64 submit(const std::string& _name, std::function<bool()> _callback);
+		bool wait();
+		bool has_failed();
+		const Job* get_first_failed_job();
+		void worker_loop();
+
+	};
+
+}
\ No newline at end of file
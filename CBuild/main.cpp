@@ -3,8 +3,18 @@
 #include "lexer.h"
 #include "parser.h"
 #include "string_helper.h"
-
+#include "job_pool.h"
+#include "benchmark.h"
+#include "include_report.h"
+#include "watcher.h"
+#include "query.h"
+#include "hash.h"
+
+#ifdef _WIN32
 #include <Windows.h>
+#else
+#include <unistd.h>
+#endif
 
 using namespace CBuild;
 
@@ -19,6 +29,16 @@ int main(int argc, char** argv) {
 
 	bool flag_force_rebuild = false;
 	bool flag_print_cmds = false;
+	bool flag_bench_scan = false;
+	bool flag_bench_stat = false;
+	bool flag_print_stats = false;
+	bool flag_report_includes = false;
+	bool flag_hash_tokens = false;
+	bool flag_watch = false;
+	bool flag_explain = false;
+	bool query = false;
+	std::vector<std::string> query_args;
+	u32 job_count = 0;
 	Config_Type config_type = Config_Type::Debug;
 	
 	for (int i = 1; i < argc; ++i) {
@@ -28,7 +48,45 @@ int main(int argc, char** argv) {
 
 		if (flag.length() > 0 && flag[0] != '-') {
 
-			if(input_file.empty()) input_file = flag;
+			//'cbuild query <kind> <file> [build file]' answers questions about the last build instead of building.
+			if (i == 1 && flag == "query") query = true;
+			else if (query && query_args.size() < 2) query_args.push_back(flag);
+			else if(input_file.empty()) input_file = flag;
+
+			continue;
+
+		}
+
+		//Number of parallel jobs, either '-j N' or '-jN'.
+		if (flag.length() >= 2 && flag[0] == '-' && flag[1] == 'j') {
+
+			std::string count = flag.substr(2);
+
+			//A bare '-j' only takes the next argument if it's a number, anything else is left for the other flags.
+			if (count.empty()) {
+
+				std::string next = (i + 1 < argc) ? argv[i + 1] : "";
+				String_Helper::trim(next);
+
+				if (!next.empty() && next.find_first_not_of("0123456789") == std::string::npos) {
+
+					count = next;
+					++i;
+
+				}
+				else continue;
+
+			}
+
+			String_Helper::trim(count);
+
+			if (count.find_first_not_of("0123456789") != std::string::npos || std::atoi(count.c_str()) <= 0) {
+				CBUILD_WARN("Invalid job count '{}', using {} jobs.", count, Job_Pool::get_default_job_count());
+			}
+			else {
+				job_count = (u32)std::atoi(count.c_str());
+			}
+
 			continue;
 
 		}
@@ -39,12 +97,27 @@ int main(int argc, char** argv) {
 			if (flag == "-force_rebuild" || flag == "-fr") flag_force_rebuild = true;
 			else if (flag == "-pcmds") flag_print_cmds = true;
 			else if (flag == "-release") config_type = Config_Type::Release;
+			else if (flag == "-bench_scan") flag_bench_scan = true;
+			else if (flag == "-bench_stat") flag_bench_stat = true;
+			else if (flag == "-stats") flag_print_stats = true;
+			else if (flag == "-report_includes") flag_report_includes = true;
+			else if (flag == "-hash_tokens") flag_hash_tokens = true;
+			else if (flag == "-watch") flag_watch = true;
+			else if (flag == "-explain") flag_explain = true;
 			else CBUILD_WARN("Unknown flag '{}' found.", flag);
 
 		}
 
 	}
 
+	//Queries fall back to the only build file in the current directory.
+	if (input_file.empty() && query) {
+
+		std::vector<std::filesystem::path> build_files;
+		if (File::find_files(".", ".cbuild", build_files) && build_files.size() == 1) input_file = build_files[0].string();
+
+	}
+
 	if (input_file.empty()) {
 
 		CBUILD_ERROR("No input file specified.");
@@ -84,6 +157,7 @@ int main(int argc, char** argv) {
 	
 	Parser parser;
 	parser.parse_tokens(&lexer);
+	parser.build_file_hash = Hash::string(source);
 
 	if (parser.error_handler.has_error()) {
 
@@ -92,6 +166,24 @@ int main(int argc, char** argv) {
 
 	}
 	
+	if (flag_bench_scan) {
+
+		Benchmark::run_include_scanner(parser);
+		return 0;
+
+	}
+
+	if (flag_bench_stat) {
+
+		Benchmark::run_stat(parser, job_count);
+		return 0;
+
+	}
+
+	if (flag_report_includes) {
+		return Include_Report::run(parser, config_type, job_count) ? 0 : 1;
+	}
+
 	if (!parser.should_build()) {
 
 		CBUILD_TRACE("Nothing to build.");
@@ -104,8 +196,14 @@ int main(int argc, char** argv) {
 	std::filesystem::path exec_path = std::filesystem::u8path(exec_dir);
 
 	char buffer[1024];
+
+#ifdef _WIN32
 	DWORD result = GetModuleFileNameA(NULL, &buffer[0], 1024); //Gets the absolute executable path of CBuild.
 	if (result != 0 && result < 1024)  exec_path = std::filesystem::u8path(buffer);
+#else
+	ssize_t result = readlink("/proc/self/exe", &buffer[0], 1023); //Gets the absolute executable path of CBuild.
+	if (result > 0 && result < 1024) exec_path = std::filesystem::u8path(std::string(buffer, result));
+#endif
 
 	exec_path = exec_path.has_parent_path() ? exec_path.parent_path() : "";
 	File::format_path(exec_path);
@@ -116,8 +214,29 @@ int main(int argc, char** argv) {
 		std::filesystem::create_directory(projects_path);
 	}
 
+	if (query) {
+		return Query::run(parser, projects_path, config_type, query_args) ? 0 : 1;
+	}
+
+	//Keep rebuilding whenever a source, header or the build file changes.
+	if (flag_watch) {
+
+		Watcher watcher;
+		watcher.build_file = input_file_path;
+		watcher.projects_path = projects_path;
+		watcher.print_cmds = flag_print_cmds;
+		watcher.config_type = config_type;
+		watcher.job_count = job_count;
+		watcher.print_stats = flag_print_stats;
+		watcher.hash_tokens = flag_hash_tokens;
+		watcher.explain = flag_explain;
+
+		return watcher.run(parser, flag_force_rebuild) ? 0 : 1;
+
+	}
+
 	//Build.
-	if (!parser.build(projects_path, flag_force_rebuild, flag_print_cmds, config_type)) {
+	if (!parser.build(projects_path, flag_force_rebuild, flag_print_cmds, config_type, job_count, flag_print_stats, flag_hash_tokens, flag_explain)) {
 		return 1;
 	}
 
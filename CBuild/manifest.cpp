@@ -0,0 +1,290 @@
+#include "pch.h"
+#include "manifest.h"
+#include "parser.h"
+#include "hash.h"
+#include "job_pool.h"
+#include "path_table.h"
+
+#include <unordered_set>
+#include <chrono>
+#include <cstdlib>
+
+namespace CBuild {
+
+	std::filesystem::path Manifest::get_path(const std::filesystem::path& _config_path, const std::string& _config_name) {
+
+		std::filesystem::path path = _config_path;
+		return path.replace_extension("." + _config_name + "_manifest");
+
+	}
+
+	u64 Manifest::get_build_digest(Parser& _parser, Config_Type _config_type, bool _hash_tokens) {
+
+		//Everything else the build depends on is spelled out in the build file.
+		//Toggling -hash_tokens has to reach the scanner once, which replaces the digests of the other kind.
+		u64 hash = Hash::combine(Hash::seed, version);
+		hash = Hash::combine(hash, _parser.build_file_hash);
+		hash = Hash::combine(hash, (u64)_config_type);
+		hash = Hash::combine(hash, _hash_tokens ? 1 : 0);
+
+		return Hash::string(_parser.compiler, hash);
+
+	}
+
+	std::filesystem::path Manifest::find_program(const std::filesystem::path& _program) {
+
+		if (_program.has_parent_path()) return _program;
+
+		//Without a compiler directory, the compiler is whatever the shell finds first.
+		const char* env_path = std::getenv("PATH");
+		if (env_path == nullptr) return _program;
+
+#ifdef _WIN32
+		const char separator = ';';
+		std::string program = _program.string() + ".exe";
+#else
+		const char separator = ':';
+		std::string program = _program.string();
+#endif
+
+		std::string paths = env_path;
+		u64 start = 0;
+
+		while (start <= paths.length()) {
+
+			u64 end = paths.find(separator, start);
+			if (end == std::string::npos) end = paths.length();
+
+			if (end > start) {
+
+				std::filesystem::path path = std::filesystem::u8path(paths.substr(start, end - start)) / std::filesystem::u8path(program);
+				if (File::file_exists(path)) return path;
+
+			}
+
+			start = end + 1;
+
+		}
+
+		return _program;
+
+	}
+
+	void Manifest::add(const std::filesystem::path& _path, u64 _time) {
+
+		Manifest_Entry& entry = entries.emplace_back();
+		entry.path = _path.empty() ? "." : _path.string();
+		entry.time = _time;
+
+	}
+
+	void Manifest::add(const std::filesystem::path& _path) {
+
+		File_Info info;
+		File::get_info(_path.empty() ? std::filesystem::path(".") : _path, info);
+
+		add(_path, info.time);
+
+	}
+
+	bool Manifest::collect(Parser& _parser, Config_Type _config_type, const std::vector<std::filesystem::path>& _source_files, const std::filesystem::path& _config_path) {
+
+		Config_Timestamps* timestamps = _parser.config.get_config_timestamps(_config_type);
+		if (timestamps == nullptr) return false;
+
+		//Files are recorded with the timestamps the build saw, not the ones they have now.
+		//A file that was saved while the build was running therefore doesn't match, and the next build picks it up.
+		std::unordered_set<std::string> added;
+
+		auto add_tracked = [this, timestamps, &added](const std::string& _path) {
+
+			if (!added.insert(_path).second) return true;
+
+			const auto& timestamp_it = timestamps->timestamps.find(_path);
+			if (timestamp_it == timestamps->timestamps.end()) return false;
+
+			add(std::filesystem::u8path(_path), timestamp_it->second);
+			return true;
+
+		};
+
+		for (const std::filesystem::path& file : _source_files) {
+
+			//Without the dependencies from its last compile, nothing says which headers a source needs.
+			const std::vector<std::string>* deps = _parser.config.get_config_dependencies(_config_type, file);
+			if (deps == nullptr || !add_tracked(file.string())) return false;
+
+			for (const std::string& dep : *deps) {
+
+				if (!added.insert(dep).second) continue;
+
+				//External headers aren't tracked one by one, their directories are checked below.
+				const auto& timestamp_it = timestamps->timestamps.find(dep);
+				if (timestamp_it != timestamps->timestamps.end()) add(std::filesystem::u8path(dep), timestamp_it->second);
+
+			}
+
+		}
+
+		if (!_parser.precompiled_header.empty()) {
+
+			if (!add_tracked(_parser.precompiled_header.string())) return false;
+			add(std::filesystem::path(_parser.precompiled_header).replace_extension(".gch"));
+
+		}
+
+		//New or removed sources show up in the listings of the directories that were walked for them.
+		for (const auto& listing_it : _parser.config.dir_listings) {
+			add(std::filesystem::u8path(listing_it.first), listing_it.second.time);
+		}
+
+		//A header added to an include directory could shadow another one.
+		for (const std::filesystem::path& incl_dir : _parser.incl_dirs) {
+			add(incl_dir);
+		}
+
+		//Same coverage as the fingerprint of an external directory: its entries and those of the directories headers were found in.
+		for (const std::filesystem::path& external_incl_dir : _parser.external_incl_dirs) {
+
+			std::filesystem::path external_dir = Path_Table::canonicalize(external_incl_dir);
+			std::vector<std::filesystem::path> dirs = { external_dir };
+
+			const auto& subdirs_it = _parser.config.external_subdirs.find(external_dir.string());
+
+			if (subdirs_it != _parser.config.external_subdirs.end()) {
+
+				for (const std::string& subdir : subdirs_it->second) {
+					dirs.push_back(external_dir / std::filesystem::u8path(subdir));
+				}
+
+			}
+
+			for (const std::filesystem::path& dir : dirs) {
+
+				//The external dir itself is one of the include dirs above.
+				std::error_code error;
+				if (dir != external_dir) add(dir);
+
+				for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(dir, error)) {
+					add(entry.path());
+				}
+
+			}
+
+		}
+
+		//Libraries the binary is linked against.
+		for (const std::filesystem::path& lib_dir : _parser.lib_dirs) {
+
+			add(lib_dir);
+
+			for (const std::string& static_lib : _parser.static_libs) {
+				add(lib_dir / std::filesystem::u8path("lib" + static_lib + ".a"));
+			}
+
+		}
+
+		//Deleting an object file or the output touches the directory it was in.
+		std::unordered_set<std::string> obj_dirs;
+
+		for (const std::filesystem::path& file : _source_files) {
+
+			std::filesystem::path obj_dir = _parser.get_obj_path(file, _config_type).parent_path();
+			if (obj_dirs.insert(obj_dir.string()).second) add(obj_dir);
+
+		}
+
+		add(_parser.get_obj_output_path(_config_type));
+		add(_parser.get_build_output_path(_config_type));
+
+		add(_config_path);
+		add(find_program(_parser.get_compiler_path(_parser.compiler)));
+
+		return true;
+
+	}
+
+	u64 Manifest::compute_digest(u64 _build_digest) {
+
+		u64 hash = _build_digest;
+
+		for (const Manifest_Entry& entry : entries) {
+
+			hash = Hash::string(entry.path, hash);
+			hash = Hash::combine(hash, entry.time);
+
+		}
+
+		return hash;
+
+	}
+
+	bool Manifest::verify(u64 _build_digest, u32 _job_count) {
+
+		auto start = std::chrono::steady_clock::now();
+
+		std::vector<std::filesystem::path> paths;
+		paths.reserve(entries.size());
+
+		for (const Manifest_Entry& entry : entries) {
+			paths.push_back(std::filesystem::u8path(entry.path));
+		}
+
+		std::vector<File_Info> infos;
+		Job_Pool job_pool(_job_count);
+
+		stat_method = Stat_Batch::stat_all(paths, infos, job_pool);
+
+		for (u64 i = 0; i < entries.size(); ++i) {
+			entries[i].time = infos[i].exists ? infos[i].time : 0;
+		}
+
+		verify_time = std::chrono::duration<f64>(std::chrono::steady_clock::now() - start).count();
+
+		return compute_digest(_build_digest) == digest;
+
+	}
+
+	bool Manifest::load(const std::filesystem::path& _path) {
+
+		std::string source;
+		if (!File::read_text_file(_path, source)) return false;
+
+		//The digest comes first, followed by one path per line.
+		u64 start = source.find('\n');
+		if (start == std::string::npos || source.compare(0, 7, "digest ") != 0) return false;
+
+		digest = std::strtoull(source.c_str() + 7, nullptr, 10);
+		++start;
+
+		while (start < source.length()) {
+
+			u64 end = source.find('\n', start);
+			if (end == std::string::npos) end = source.length();
+
+			if (end > start) entries.emplace_back().path = source.substr(start, end - start);
+			start = end + 1;
+
+		}
+
+		return true;
+
+	}
+
+	bool Manifest::save(const std::filesystem::path& _path, u64 _build_digest) {
+
+		std::string source = "digest " + std::to_string(compute_digest(_build_digest)) + "\n";
+
+		for (const Manifest_Entry& entry : entries) {
+			source += entry.path + "\n";
+		}
+
+		return File::write_text_file(_path, source);
+
+	}
+
+	void Manifest::print_stats() {
+		CBUILD_TRACE("Manifest: {} paths verified in {:.2f} ms ({})", entries.size(), verify_time * 1000.0, Stat_Batch::method_to_string(stat_method));
+	}
+
+}
\ No newline at end of file
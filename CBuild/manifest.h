@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "types.h"
+#include "config.h"
+#include "stat_batch.h"
+
+namespace CBuild {
+
+	struct Parser;
+
+	struct Manifest_Entry {
+
+		std::string path;
+		u64 time = 0; //Zero if the path doesn't exist.
+
+	};
+
+	//Snapshot of everything a build read: the build file, the toolchain, and the metadata of its files and directories.
+	//All of it is folded into one digest, so a build that would do nothing only has to stat the snapshot and compare.
+	struct Manifest {
+
+		static constexpr u64 version = 3;
+
+		u64 digest = 0;
+		std::vector<Manifest_Entry> entries;
+
+		Stat_Method stat_method = Stat_Method::Sequential;
+		f64 verify_time = 0.0;
+
+		static std::filesystem::path get_path(const std::filesystem::path& _config_path, const std::string& _config_name);
+		static u64 get_build_digest(Parser& _parser, Config_Type _config_type, bool _hash_tokens);
+		static std::filesystem::path find_program(const std::filesystem::path& _program);
+
+		void add(const std::filesystem::path& _path, u64 _time);
+		void add(const std::filesystem::path& _path);
+		bool collect(Parser& _parser, Config_Type _config_type, const std::vector<std::filesystem::path>& _source_files, const std::filesystem::path& _config_path);
+		u64 compute_digest(u64 _build_digest);
+		bool verify(u64 _build_digest, u32 _job_count);
+		bool load(const std::filesystem::path& _path);
+		bool save(const std::filesystem::path& _path, u64 _build_digest);
+		void print_stats();
+
+	};
+
+}
\ No newline at end of file
@@ -3,8 +3,19 @@
 #include "lexer.h"
 #include "log.h"
 #include "file.h"
+#include "build_graph.h"
+#include "depfile.h"
+#include "dependency_scanner.h"
+#include "dir_walker.h"
+#include "glob.h"
+#include "path_table.h"
+#include "explain.h"
+#include "manifest.h"
 
 #include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <unordered_set>
 
 #define COMMAND_FUNC(func) std::bind(&func, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3)
 
@@ -27,7 +38,10 @@ namespace CBuild {
 		cmds["set_run_binary"]			= { COMMAND_FUNC(Parser::parse_cmd_set_run_binary) };
 		cmds["add_src_dirs"]			= { COMMAND_FUNC(Parser::parse_cmd_add_src_dirs) };
 		cmds["add_src_files"]			= { COMMAND_FUNC(Parser::parse_cmd_add_src_files) };
+		cmds["add_src_globs"]			= { COMMAND_FUNC(Parser::parse_cmd_add_src_globs) };
+		cmds["add_src_excludes"]		= { COMMAND_FUNC(Parser::parse_cmd_add_src_excludes) };
 		cmds["add_incl_dirs"]			= { COMMAND_FUNC(Parser::parse_cmd_add_incl_dirs) };
+		cmds["add_external_incl_dirs"]	= { COMMAND_FUNC(Parser::parse_cmd_add_external_incl_dirs) };
 		cmds["add_lib_dirs"]			= { COMMAND_FUNC(Parser::parse_cmd_add_lib_dirs) };
 		cmds["add_static_libs"]			= { COMMAND_FUNC(Parser::parse_cmd_add_static_libs) };
 
@@ -475,10 +489,46 @@ namespace CBuild {
 		return parse_cmd_add_files(_index, _cur_token, _prev_token, src_files);
 	}
 
+	bool Parser::parse_cmd_add_src_globs(u64& _index, Token& _cur_token, Token& _prev_token) {
+		return parse_cmd_add_globs(_index, _cur_token, _prev_token, src_globs);
+	}
+
+	bool Parser::parse_cmd_add_src_excludes(u64& _index, Token& _cur_token, Token& _prev_token) {
+		return parse_cmd_add_globs(_index, _cur_token, _prev_token, src_excludes);
+	}
+
 	bool Parser::parse_cmd_add_incl_dirs(u64& _index, Token& _cur_token, Token& _prev_token) {
 		return parse_cmd_add_dirs(_index, _cur_token, _prev_token, incl_dirs);
 	}
 
+	bool Parser::parse_cmd_add_external_incl_dirs(u64& _index, Token& _cur_token, Token& _prev_token) {
+
+		u64 count = external_incl_dirs.size();
+		if (!parse_cmd_add_dirs(_index, _cur_token, _prev_token, external_incl_dirs)) return false;
+
+		for (u64 i = count; i < external_incl_dirs.size(); ++i) {
+
+			bool exists = false;
+
+			for (const std::filesystem::path& path : incl_dirs) {
+
+				if (File::compare(path, external_incl_dirs[i])) {
+
+					exists = true;
+					break;
+
+				}
+
+			}
+
+			if (!exists) incl_dirs.push_back(external_incl_dirs[i]);
+
+		}
+
+		return true;
+
+	}
+
 	bool Parser::parse_cmd_add_lib_dirs(u64& _index, Token& _cur_token, Token& _prev_token) {
 		return parse_cmd_add_dirs(_index, _cur_token, _prev_token, lib_dirs);
 	}
@@ -615,6 +665,56 @@ namespace CBuild {
 
 	}
 
+	bool Parser::parse_cmd_add_globs(u64& _index, Token& _cur_token, Token& _prev_token, std::vector<std::string>& _globs) {
+
+		Token cmd_token = _cur_token;
+
+		get_next_token(_index, _cur_token, _prev_token);
+
+		if (_cur_token.type != Token_Type::String) {
+
+			std::string msg = "Expected at least 1 'pattern' argument in command '" + _prev_token.value + "'";
+			error_handler.set_error(Error_Type::Error, msg, _cur_token.line_pos, _cur_token.char_pos);
+			return false;
+
+		}
+
+		while (_cur_token.type == Token_Type::String) {
+
+			//Same as a path, except for the wildcards.
+			std::string path = _cur_token.value;
+			path.erase(std::remove_if(path.begin(), path.end(), [](char _char) { return _char == '*' || _char == '?'; }), path.end());
+
+			if (_cur_token.value.empty() || !lexer->is_valid_path_string(path)) {
+
+				std::string msg = "Invalid pattern '" + _cur_token.value + "' in command '" + cmd_token.value + "'";
+				error_handler.set_error(Error_Type::Error, msg, _cur_token.line_pos, _cur_token.char_pos);
+				return false;
+
+			}
+
+			std::string glob = Glob::normalize(_cur_token.value);
+
+			if (std::find(_globs.begin(), _globs.end(), glob) != _globs.end()) {
+
+				std::string msg = "Pattern '" + _cur_token.value + "' has already been added in command '" + cmd_token.value + "'";
+				error_handler.warn(msg, _cur_token.line_pos, _cur_token.char_pos);
+
+			}
+			else {
+				_globs.push_back(glob);
+			}
+
+			get_next_token(_index, _cur_token, _prev_token);
+
+		}
+
+		get_prev_token(_index, _cur_token, _prev_token);
+
+		return parse_semicolon(_index, _cur_token, _prev_token);
+
+	}
+
 	bool Parser::parse_cmd_add_strings(u64& _index, Token& _cur_token, Token& _prev_token, std::vector<std::string>& _strings, bool _validate_strings) {
 
 		Token cmd_token = _cur_token;
@@ -672,200 +772,216 @@ namespace CBuild {
 
 	}
 
-	bool Parser::parse_source_and_header_files(const std::filesystem::path& _path, Config_Type _config_type, const std::string& _compiler) {
+	bool Parser::has_timestamp_changed(const std::filesystem::path& _path, Config_Type _config_type, u64 _time) {
 
-		//@TODO: Standard libraries?
+		Config_Timestamps* timestamps = config.get_config_timestamps(_config_type);
+		if (timestamps == nullptr) return true;
 
-		//Check if the file has already been parsed.
-		for (const Checked_File& checked_file : checked_files) {
+		const auto& it = timestamps->timestamps.find(_path.string());
+		if (it == timestamps->timestamps.end()) return true;
 
-			if (File::compare(checked_file.path, _path)) {
-				return checked_file.rebuild;
-			}
+		return (it->second != _time);
 
-		}
+	}
+
+	std::filesystem::path Parser::get_atmel_studio_include_path() {
 
-		bool should_rebuild = (config.last_used_compiler != _compiler);
+		std::filesystem::path path = atmel_studio_dir / std::filesystem::u8path("Packs\\atmel\\ATmega_DFP\\1.6.364\\include");
+		File::format_path(path);
 
-		if (!File::file_exists(_path)) {
+		return path;
 
-			checked_files.push_back({ _path, false, 0 });
-			return false;
+	}
 
-		}
+	std::filesystem::path Parser::get_atmel_studio_mcu_path() {
 
-		//Rebuild source file if object file does not exist.
-		std::filesystem::path obj_output_path = get_obj_output_path(_config_type);
+		std::filesystem::path path = atmel_studio_dir / std::filesystem::u8path("Packs\\atmel\\ATmega_DFP\\1.6.364\\gcc\\dev\\" + avr_mcu);
+		File::format_path(path);
 
-		if (!should_rebuild && _path.extension().string() == ".c") {
+		return path;
 
-			std::filesystem::path obj_file_path = obj_output_path / _path.filename().replace_extension(".o");
-			File::format_path(obj_file_path);
+	}
 
-			if (!File::file_exists(obj_file_path)) should_rebuild = true;
+	std::filesystem::path Parser::get_obj_output_path(Config_Type _config_type) {
+		return obj_output / std::filesystem::u8path(config.config_type_to_string(_config_type));
+	}
 
-		}
+	std::filesystem::path Parser::get_obj_path(const std::filesystem::path& _source, Config_Type _config_type, const std::string& _extension) {
 
-		//Compare timestamps.
-		//@TODO: Check checksum instead?
-		Config_Timestamps* timestamps = config.get_config_timestamps(_config_type);
+		const auto& it = obj_names.find(_source.string());
+		std::filesystem::path name = (it != obj_names.end()) ? it->second : _source.filename();
 
-		u64 time = std::filesystem::last_write_time(_path).time_since_epoch().count();
+		std::filesystem::path path = get_obj_output_path(_config_type) / name;
+		path.replace_extension(_extension);
+		File::format_path(path);
 
-		if (!should_rebuild) {
+		return path;
 
-			if (timestamps != nullptr && timestamps->timestamps.find(_path.string()) != timestamps->timestamps.end()) {
+	}
 
-				u64 old_time = timestamps->timestamps[_path.string()];
-				if (old_time != time) should_rebuild = true;
+	std::filesystem::path Parser::get_build_output_path(Config_Type _config_type) {
+		return build_output / std::filesystem::u8path(config.config_type_to_string(_config_type));
+	}
 
-			}
-			else {
-				should_rebuild = true;
-			}
+	std::filesystem::path Parser::get_compiler_path(const std::string _name) {
 
-		}
+		std::filesystem::path path = compiler_dir;
+		path /= std::filesystem::u8path(_name);
+		File::format_path(path);
 
-		//Parse include directives in file.
-		std::string source;
-		if (!File::read_text_file(_path, source)) {
-			checked_files.push_back({ _path, false, time });
-			return false;
-		}
+		return path;
 
-		std::vector<std::string> local_files;
-		std::vector<std::string> include_files;
-		c_lexer.clear();
-		c_lexer.parse_source(source);
+	}
 
-		for (u64 i = 0; i < c_lexer.include_indices.size(); ++i) {
+	bool Parser::find_source_files(std::vector<std::filesystem::path>& _files, u64* _listed_dirs) {
 
-			u64 ind = c_lexer.include_indices[i];
+		//Source dirs are globs that only match their own files, all of them share one parallel walk.
+		//Directories that haven't been modified since the last build reuse their cached listing instead of being enumerated.
+		Dir_Walker dir_walker(config, 0);
+		dir_walker.excludes = src_excludes;
 
-			C_Token& token = c_lexer.tokens[ind];
+		std::vector<std::string> patterns;
+		std::vector<std::filesystem::path> roots; //Objects are named after the path of their source below the root it was found in.
 
-			++ind;
-			if (ind >= c_lexer.tokens.size()) continue;
+		for (const std::filesystem::path& src_path : src_dirs) {
+			
+			if (!File::directory_exists(src_path)) {
 
-			token = c_lexer.tokens[ind];
+				CBUILD_ERROR("Directory '" + src_path.string() + "' does not exist.");
+				return false;
 
-			if (token.type == C_Token_Type::String) {
-				local_files.push_back(token.value);
-			}
-			else if (token.type == C_Token_Type::Include_String) {
-				include_files.push_back(token.value);
 			}
 
-		}
+			dir_walker.add_root(src_path, 0);
+			patterns.push_back(Glob::normalize(src_path.string()) + "/*.c");
+			roots.push_back(src_path);
 
-		for (const std::string& local_file : local_files) {
+		}
 
-			std::filesystem::path local_path = _path.has_parent_path() ? _path.parent_path() / std::filesystem::u8path(local_file) : std::filesystem::u8path(local_file);
-			File::format_path(local_path);
-			
-			//Fallback to include.
-			if (!File::file_exists(local_path)) {
+		for (const std::string& glob : src_globs) {
 
-				bool add = true;
-				for (const std::string& temp : include_files) {
-					if (File::compare(temp, local_file)) {
-						add = false;
-						break;
-					}
-				}
+			std::filesystem::path base_dir = Glob::get_base_dir(glob);
 
-				if (add) include_files.push_back(local_file);
+			if (!base_dir.empty() && !File::directory_exists(base_dir)) {
 
+				CBUILD_WARN("Directory '{}' of source glob '{}' does not exist.", base_dir.string(), glob);
 				continue;
 
 			}
 
-			if (File::compare(_path, local_path)) continue;
-			if (parse_source_and_header_files(local_path, _config_type, _compiler)) should_rebuild = true;
+			dir_walker.add_root(base_dir, Glob::get_depth(glob));
+			patterns.push_back(glob);
+			roots.push_back(base_dir);
 
 		}
 
-		std::string incl_path = "";
-		for (const std::string& include_file : include_files) {
+		dir_walker.wait();
+
+		obj_names.clear();
+
+		for (const std::filesystem::path& file : dir_walker.files) {
+
+			std::string path = file.string();
+			if (dir_walker.is_excluded(file)) continue;
+
+			for (u64 i = 0; i < patterns.size(); ++i) {
 
-			for (const std::filesystem::path& include_dir : incl_dirs) {
+				if (Glob::match(patterns[i], path)) {
 
-				std::filesystem::path incl_path = include_dir / std::filesystem::u8path(include_file);
-				File::format_path(incl_path);
+					std::filesystem::path name = roots[i].empty() ? file : file.lexically_relative(roots[i]);
+					if (name.empty() || *name.begin() == "..") name = file.filename();
 
-				if (!File::file_exists(incl_path)) continue;
-				if (File::compare(_path, incl_path)) continue;
-				if (parse_source_and_header_files(incl_path, _config_type, _compiler)) should_rebuild = true;
+					_files.push_back(file);
+					obj_names[path] = name;
+
+					break;
+
+				}
 
 			}
 
 		}
 
-		checked_files.push_back({ _path, should_rebuild, time });
-		return should_rebuild;
+		for (const std::filesystem::path& file : src_files) {
 
-	}
+			if (std::find(_files.begin(), _files.end(), file) != _files.end()) continue;
 
-	std::filesystem::path Parser::get_atmel_studio_include_path() {
+			_files.push_back(file);
+			obj_names[file.string()] = file.filename();
 
-		std::filesystem::path path = atmel_studio_dir / std::filesystem::u8path("Packs\\atmel\\ATmega_DFP\\1.6.364\\include");
-		File::format_path(path);
+		}
 
-		return path;
+		//Two sources compiled to the same object would overwrite each other and break the link.
+		std::unordered_map<std::string, const std::filesystem::path*> objects;
 
-	}
+		for (const std::filesystem::path& file : _files) {
 
-	std::filesystem::path Parser::get_atmel_studio_mcu_path() {
+			std::filesystem::path obj_name = std::filesystem::path(obj_names[file.string()]).replace_extension(".o");
+			File::format_path(obj_name);
 
-		std::filesystem::path path = atmel_studio_dir / std::filesystem::u8path("Packs\\atmel\\ATmega_DFP\\1.6.364\\gcc\\dev\\" + avr_mcu);
-		File::format_path(path);
+			const auto& result = objects.emplace(obj_name.string(), &file);
 
-		return path;
+			if (!result.second) {
 
-	}
+				CBUILD_ERROR("Source files '{}' and '{}' would both compile to '{}'.", result.first->second->string(), file.string(), obj_name.string());
+				return false;
+
+			}
+
+		}
+
+		//Listings of directories that are no longer walked are dropped.
+		config.dir_listings = std::move(dir_walker.listings);
+		if (_listed_dirs != nullptr) *_listed_dirs = dir_walker.listed_dirs;
+
+		return true;
 
-	std::filesystem::path Parser::get_obj_output_path(Config_Type _config_type) {
-		return obj_output / std::filesystem::u8path(config.config_type_to_string(_config_type));
 	}
 
-	std::filesystem::path Parser::get_build_output_path(Config_Type _config_type) {
-		return build_output / std::filesystem::u8path(config.config_type_to_string(_config_type));
+	bool Parser::should_build() {
+		return (src_dirs.size() > 0 || src_files.size() > 0 || src_globs.size() > 0);
 	}
 
-	std::filesystem::path Parser::get_compiler_path(const std::string _name) {
+	std::filesystem::path Parser::get_config_path(const std::filesystem::path& _projects_path) {
 
-		std::filesystem::path path = compiler_dir;
-		path /= std::filesystem::u8path(_name);
-		File::format_path(path);
+		std::filesystem::path config_path = _projects_path / std::filesystem::u8path(project_name + ".cbuild_config");
+		std::hash<std::string> hash;
 
-		return path;
+		return _projects_path / std::filesystem::u8path(project_name + "_" + std::to_string(hash(config_path.string())) + ".cbuild_config");
 
 	}
 
-	bool Parser::should_build() {
-		return (src_dirs.size() > 0 || src_files.size() > 0);
+	void Parser::load_build_config(const std::filesystem::path& _config_path) {
+
+		//Every build saves the config it changed, so when watching, the copy in memory is still current.
+		if (File::compare(loaded_config_path, _config_path)) return;
+
+		config.clear_config();
+		config.load_config(_config_path);
+
+		loaded_config_path = _config_path;
+
 	}
 
-	bool Parser::build(const std::filesystem::path& _projects_path, bool _force_rebuild, bool _print_cmds, Config_Type _config_type) {
+	bool Parser::build(const std::filesystem::path& _projects_path, bool _force_rebuild, bool _print_cmds, Config_Type _config_type, u32 _job_count, bool _print_stats, bool _hash_tokens, bool _explain) {
 
 		exec_path = _projects_path.parent_path();
 		
 		if (compiler == "gcc" || compiler == "avr-gcc" || compiler == "clang") {
-			return build_gcc_clang(compiler, _projects_path, _force_rebuild, _print_cmds, _config_type);
+			return build_gcc_clang(compiler, _projects_path, _force_rebuild, _print_cmds, _config_type, _job_count, _print_stats, _hash_tokens, _explain);
 		}
 
 		return true;
 
 	}
 
-	bool Parser::build_gcc_clang(const std::string& _compiler, const std::filesystem::path& _projects_path, bool _force_rebuild, bool _print_cmds, Config_Type _config_type) {
+	bool Parser::build_gcc_clang(const std::string& _compiler, const std::filesystem::path& _projects_path, bool _force_rebuild, bool _print_cmds, Config_Type _config_type, u32 _job_count, bool _print_stats, bool _hash_tokens, bool _explain) {
 
 		//@TODO: Display what compiler is used and time measurment.
 		//@TODO: Reset to white.
 		//@TODO: Check if library updated.
-		//@TODO: Check timestamp of build file?
 		
-		std::string cmd;
+		std::vector<std::string> cmd;
 
 		const auto& spec_it = compiler_specs.find(_compiler);
 		if (spec_it == compiler_specs.end()) {
@@ -935,20 +1051,46 @@ namespace CBuild {
 
 		bool built_something = false;
 
-		//Load config file.
-		config.clear_config();
+		std::filesystem::path config_path = get_config_path(_projects_path);
+		std::filesystem::path manifest_path = Manifest::get_path(config_path, config.config_type_to_string(_config_type));
+		u64 build_digest = Manifest::get_build_digest(*this, _config_type, _hash_tokens);
 
-		std::filesystem::path config_path = _projects_path / std::filesystem::u8path(project_name + ".cbuild_config");
-		std::hash<std::string> hash;
-		config_path = _projects_path / std::filesystem::u8path(project_name + "_" + std::to_string(hash(config_path.string())) + ".cbuild_config");
-		
-		config.load_config(config_path);
+		//When nothing the last build read has changed, checking its snapshot is all there is to do.
+		//The config isn't loaded, no source is looked at, and the link is skipped.
+		//A binary that should be run or flashed after building still goes through the link step, which does that.
+		if (!_force_rebuild && !_explain && build_file_hash != 0 && !(run_binary && build_type == Build_Type::Binary)) {
+
+			Manifest manifest;
+
+			if (manifest.load(manifest_path) && manifest.verify(build_digest, _job_count)) {
+
+				CBUILD_TRACE("Everything is up-to-date.");
+				if (_print_stats) manifest.print_stats();
+
+				return true;
+
+			}
+
+		}
+
+		//The snapshot is only written again once this build succeeds.
+		std::error_code error;
+		std::filesystem::remove(manifest_path, error);
+
+		//Load config file.
+		load_build_config(config_path);
 
 		Config_Timestamps* timestamps = config.get_config_timestamps(_config_type);
 
+		//Every step of the build is a node in the build graph: the PCH, each object file and the final archive/link.
+		//Object files only wait for the PCH if they actually include it, and the link runs as soon as its last input is done.
+		Build_Graph build_graph(_job_count);
+
 		//Compile precompiled header.
 		bool built_pch = false;
 		u64 pch_time = 0;
+		u64 pch_node = 0;
+		u64 pch_command = 0;
 
 		if (!precompiled_header.empty()) {
 
@@ -981,10 +1123,19 @@ namespace CBuild {
 			}
 			else {
 				
-				u64 time = std::filesystem::last_write_time(precompiled_header).time_since_epoch().count();
+				File_Info pch_info;
+				File::get_info(precompiled_header, pch_info);
+
+				u64 time = pch_info.time;
+
+				cmd = compiler->build_pch_cmd(precompiled_header, _config_type, *this);
+				pch_command = Compiler_Spec::hash_cmd(cmd);
 
+				u64 old_command = 0;
+
+				//The .gch is shared by both config types, so it's also rebuilt when the other one was built last.
 				if (_force_rebuild || !File::file_exists(std::filesystem::path(precompiled_header).replace_extension(".gch"))) built_pch = true;
-				else if (config.last_used_type != _config_type || config.last_used_compiler != _compiler) {
+				else if (config.last_used_type != _config_type || !config.get_config_command(_config_type, precompiled_header, old_command) || old_command != pch_command) {
 					built_pch = true;
 				}
 				else {
@@ -1004,19 +1155,17 @@ namespace CBuild {
 				pch_time = time;
 
 				if (built_pch) {
-					
-					cmd = compiler->build_pch_cmd(precompiled_header, _config_type, *this);
 
-					CBUILD_TRACE("Compiling PCH '{}'", precompiled_header.string());
+					std::filesystem::path pch_path = precompiled_header;
 
-					if (_print_cmds) CBUILD_TRACE(cmd);
-					
-					if (system(cmd.c_str()) != 0) { //@TODO: Check if returned with warning?
+					pch_node = build_graph.add_node("PCH '" + pch_path.string() + "'", [pch_path, cmd, _print_cmds](Process_Result& _result) {
 
-						CBUILD_ERROR("An error occurred while compiling precompiled header.");
-						return false;
+						CBUILD_TRACE("Compiling PCH '{}'", pch_path.string());
 
-					}
+						if (_print_cmds) CBUILD_TRACE(Process::args_to_string(cmd));
+						return Process::run(cmd, _result); //@TODO: Check if returned with warning?
+
+					}, {}, "An error occurred while compiling precompiled header.");
 
 				}
 
@@ -1025,109 +1174,250 @@ namespace CBuild {
 		}
 		
 		//Compile source files.
-		std::vector<std::filesystem::path> src_dir_files;
+		//Dependencies are scanned in parallel, and out-of-date sources are queued the moment their includes have been checked,
+		//so compilers run while the remaining sources are still being scanned.
+		build_graph.start();
+
+		Dependency_Scanner dependency_scanner(*this, _config_type, _compiler, _job_count);
+		dependency_scanner.hash_tokens = _hash_tokens;
+
+		std::vector<std::filesystem::path> source_files;
 		std::vector<std::filesystem::path> obj_files;
+		std::vector<std::filesystem::path> compile_files;
+		std::vector<u64> compile_commands;
+		std::vector<u64> obj_nodes;
 
-		for (const std::filesystem::path& src_path : src_dirs) {
-			
-			if (!File::directory_exists(src_path)) {
+		u64 listed_dirs = 0;
+		if (!find_source_files(source_files, &listed_dirs)) return false;
 
-				CBUILD_ERROR("Directory '" + src_path.string() + "' does not exist.");
-				return false;
+		dependency_scanner.prefetch(source_files);
+
+		//Only sources reached from a changed file through the reverse dependency index have to be scanned.
+		std::vector<bool> affected;
+		if (_force_rebuild || !dependency_scanner.find_affected_sources(source_files, affected)) affected.assign(source_files.size(), true);
+
+		//Each object is rebuilt when the command it would be compiled with differs from the one it was compiled with.
+		//That covers the compiler, the config type, include dirs and anything else in the build file that ends up in the command.
+		std::vector<u64> commands(source_files.size());
+		std::vector<bool> command_changed(source_files.size());
+
+		for (u64 i = 0; i < source_files.size(); ++i) {
+
+			commands[i] = Compiler_Spec::hash_cmd(compiler->build_source_cmd(source_files[i], _config_type, *this));
+
+			u64 old_command = 0;
+			command_changed[i] = (!config.get_config_command(_config_type, source_files[i], old_command) || old_command != commands[i]);
+
+			//Scanned as well, so the object knows whether it has to wait for the PCH.
+			if (command_changed[i]) affected[i] = true;
+
+		}
+
+		for (u64 i = 0; i < source_files.size(); ++i) {
+			if (affected[i]) dependency_scanner.add_file(source_files[i], true);
+		}
+
+		//Why each object is rebuilt, and how long it took to find out.
+		std::vector<Rebuild_Explanation> explanations;
+
+		for (u64 i = 0; i < source_files.size(); ++i) {
+
+			const std::filesystem::path& file = source_files[i];
+
+			std::filesystem::path obj_path = get_obj_path(file, _config_type);
+			obj_files.push_back(obj_path);
+
+			auto decide_start = std::chrono::steady_clock::now();
+
+			Rebuild_Explanation* explanation = nullptr;
+
+			if (_explain) {
+
+				explanation = &explanations.emplace_back();
+				explanation->source = file;
+
+			}
+
+			bool built = affected[i] && dependency_scanner.should_rebuild(file, explanation, command_changed[i]);
+
+			if (explanation != nullptr) {
+
+				if (_force_rebuild) explanation->reason = Rebuild_Reason::Forced;
+				explanation->decide_time = std::chrono::duration<f64>(std::chrono::steady_clock::now() - decide_start).count();
+
+				//Printed before the compile is queued, so the reason shows up ahead of its output.
+				if (explanation->reason != Rebuild_Reason::None) Explain::print(*explanation);
 
 			}
-			
-			if (!File::find_files(src_path, ".c", src_dir_files)) continue;
-			
-			for (const std::filesystem::path& file : src_dir_files) {
 
-				std::filesystem::path obj_path = obj_output_path / file.filename().replace_extension(".o");
-				obj_files.push_back(obj_path);
+			if (!built && !_force_rebuild) continue;
+
+			//Sources found below their root keep their subdirectory in the obj output.
+			if (!File::directory_exists(obj_path.parent_path())) {
+				std::filesystem::create_directories(obj_path.parent_path());
+			}
 
-				bool built = parse_source_and_header_files(file, _config_type, _compiler);
-				if (!built && !_force_rebuild) continue;
+			std::vector<u64> deps;
+			if (built_pch && dependency_scanner.includes_file(file, precompiled_header)) deps.push_back(pch_node);
 
-				cmd = compiler->build_source_cmd(file, _config_type, *this);
+			cmd = compiler->build_source_cmd(file, _config_type, *this);
+
+			obj_nodes.push_back(build_graph.add_node("'" + file.string() + "'", [file, cmd, _print_cmds](Process_Result& _result) {
 
 				CBUILD_TRACE("Compiling '{}'", file.string());
 
-				if (_print_cmds) CBUILD_TRACE(cmd);
-				if (system(cmd.c_str()) != 0) { //@TODO: Check if returned with warning?
+				if (_print_cmds) CBUILD_TRACE(Process::args_to_string(cmd));
+				return Process::run(cmd, _result); //@TODO: Check if returned with warning?
 
-					CBUILD_ERROR("An error occurred.");
-					config.save_config(config_path);
+			}, deps, "An error occurred while compiling '" + file.string() + "'."));
 
-					return false;
+			compile_files.push_back(file);
+			compile_commands.push_back(commands[i]);
+			built_something = true;
 
-				}
+		}
+
+		if (_explain) {
+
+			Explain::print_summary(explanations);
 
-				built_something = true;
+			std::filesystem::path explain_path = obj_output_path / std::filesystem::u8path("explain.json");
+			if (!Explain::write_json(explain_path, explanations)) CBUILD_WARN("Error writing '{}'.", explain_path.string());
+
+		}
+
+		//Generate static lib.
+		if (build_type == Build_Type::Static_Lib) {
+
+			std::string lib_name = "lib" + build_name + ".a";
+			std::filesystem::path lib_path = build_output_path / std::filesystem::u8path(lib_name);
+
+			build_graph.add_node("'" + lib_path.string() + "'", [this, compiler, lib_path, obj_files, _config_type, _print_cmds](Process_Result& _result) mutable {
+				return compiler->build_static_lib(lib_path, obj_files, _config_type, _print_cmds, *this, _result);
+			}, obj_nodes);
+
+		}
+
+		//Generate binary.
+		else if (build_type == Build_Type::Binary) {
+
+			std::filesystem::path bin_path = build_output_path / std::filesystem::u8path(build_name);
+
+			build_graph.add_node("'" + bin_path.string() + "'", [this, compiler, bin_path, obj_files, _config_type, _print_cmds](Process_Result& _result) mutable {
+				return compiler->build_binary(bin_path, obj_files, _config_type, _print_cmds, *this, _result);
+			}, obj_nodes);
+
+		}
+
+		//Let running jobs finish before touching the config, and report the first failure in submission order.
+		//Archive and link steps log their own errors.
+		bool success = build_graph.wait();
+		bool compiled = true;
+
+		if (!success) {
+
+			const Build_Node* failed_node = build_graph.get_first_failed_node();
+			if (failed_node != nullptr && !failed_node->error_message.empty()) {
+
+				if (failed_node->result.started) CBUILD_ERROR("{} (exit code {})", failed_node->error_message, failed_node->result.exit_code);
+				else CBUILD_ERROR(failed_node->error_message);
 
 			}
 
+			for (u64 i = 0; i < obj_nodes.size() && compiled; ++i) {
+				if (build_graph.nodes[obj_nodes[i]].state != Job_State::Succeeded) compiled = false;
+			}
+
+			if (built_pch && build_graph.nodes[pch_node].state != Job_State::Succeeded) compiled = false;
+
 		}
 
-		for (const std::filesystem::path& src_file : src_files) {
+		if (!compiled) {
 
-			std::filesystem::path obj_path = obj_output_path / src_file.filename().replace_extension(".o");
-			obj_files.push_back(obj_path);
+			config.save_config(config_path);
+			return false;
 
-			bool built = parse_source_and_header_files(src_file, _config_type, _compiler);
-			if (!built && !_force_rebuild) continue;
+		}
 
-			cmd = compiler->build_source_cmd(src_file, _config_type, *this);
+		//Scan jobs read the config, so it's only written once they're done.
+		dependency_scanner.wait();
 
-			CBUILD_TRACE("Compiling '{}'", src_file.string());
+		for (u64 i = 0; i < compile_files.size(); ++i) {
+			config.set_config_command(_config_type, compile_files[i], compile_commands[i]);
+		}
 
-			if (_print_cmds) CBUILD_TRACE(cmd);
-			if (system(cmd.c_str()) != 0) {
+		//Commands of sources that are no longer part of the build are dropped.
+		std::vector<std::filesystem::path> command_files = source_files;
+		if (!precompiled_header.empty()) command_files.push_back(precompiled_header);
 
-				CBUILD_ERROR("An error occurred.");
-				config.save_config(config_path);
+		config.prune_config_commands(_config_type, command_files);
 
-				return false;
+		//Store the dependencies reported by the compiler, so these sources don't have to be lexed on the next build.
+		std::vector<std::filesystem::path> deps;
+		std::vector<std::filesystem::path> new_deps;
+
+		for (const std::filesystem::path& file : compile_files) {
 
+			if (!Depfile::read(compiler->get_dep_path(file, _config_type, *this), deps)) continue;
+
+			//Stored the way the scanner names files, so the reverse dependency index can be looked up by any spelling of a path.
+			for (std::filesystem::path& dep : deps) {
+				dep = Path_Table::canonicalize(dep);
 			}
 
-			built_something = true;
+			//A header included more than once, or under more than one spelling, is listed more than once.
+			std::unordered_set<std::string> seen;
+			deps.erase(std::remove_if(deps.begin(), deps.end(), [&file, &seen](const std::filesystem::path& _dep) { return File::compare(_dep, file) || !seen.insert(_dep.string()).second; }), deps.end());
+			config.set_config_dependencies(_config_type, file, deps);
+
+			new_deps.insert(new_deps.end(), deps.begin(), deps.end());
 
 		}
 
 		config.last_used_type = _config_type;
 		config.last_used_compiler = _compiler;
 
-		for (const Checked_File& checked_file : checked_files) {
-			config.set_config_timestamp(_config_type, checked_file.path, checked_file.time);
+		//Headers that are new to these sources need a timestamp as well.
+		//This queues scan jobs, storing the timestamps waits for them before the config is written again.
+		dependency_scanner.add_dependencies(new_deps);
+
+		bool touched = dependency_scanner.store_timestamps();
+		if (_print_stats) {
+
+			dependency_scanner.print_stats();
+			build_graph.print_stats();
+
 		}
 
 		if (built_pch) {
 
 			config.set_config_timestamp(_config_type, precompiled_header, pch_time);
+			config.set_config_command(_config_type, precompiled_header, pch_command);
 			built_something = true;
 
 		}
 
 		if (!built_something) {
-			CBUILD_TRACE("Everything is up-to-date.");
+
+			//A failed link has already reported its error.
+			if (success) CBUILD_TRACE("Everything is up-to-date.");
+
+			//Files that were rewritten without changing their content get their new timestamp, so they aren't hashed again.
+			//The same goes for directories that had to be listed again.
+			if (touched || listed_dirs > 0) config.save_config(config_path);
+
 		}
 		else {
 			config.save_config(config_path);
 		}
 
-		//Generate static lib.
-		if (build_type == Build_Type::Static_Lib) {
+		if (!success) return false;
 
-			std::string lib_name = "lib" + build_name + ".a";
-			std::filesystem::path lib_path = build_output_path / std::filesystem::u8path(lib_name);
-			if (!compiler->build_static_lib(lib_path, obj_files, _config_type, _print_cmds, *this)) return false;
-
-		}
+		//Snapshot of what this build read, for the next one to compare against.
+		if (build_file_hash != 0) {
 
-		//Generate binary.
-		else if (build_type == Build_Type::Binary) {
-
-			std::filesystem::path bin_path = build_output_path / std::filesystem::u8path(build_name);
-			if (!compiler->build_binary(bin_path, obj_files, _config_type, _print_cmds, *this)) return false;
+			Manifest manifest;
+			if (manifest.collect(*this, _config_type, source_files, config_path) && !manifest.save(manifest_path, build_digest)) CBUILD_WARN("Error writing '{}'.", manifest_path.string());
 
 		}
 
@@ -7,7 +7,6 @@
 
 #include "types.h"
 #include "error_handler.h"
-#include "c_lexer.h"
 #include "string_helper.h"
 #include "config.h"
 #include "compiler_spec.h"
@@ -30,20 +29,12 @@ namespace CBuild {
 
 	};
 
-	struct Checked_File {
-
-		std::filesystem::path path;
-		bool rebuild = false;
-		u64 time = 0;
-
-	};
-
 	struct Parser {
 
 		Error_Handler error_handler;
 		Lexer* lexer = nullptr;
-		C_Lexer c_lexer;
 		Config config;
+		std::filesystem::path loaded_config_path = ""; //Config that has been loaded into memory.
 
 		std::unordered_map<std::string, Command> cmds;
 		std::unordered_map<std::string, Compiler_Spec*> compiler_specs;
@@ -66,13 +57,18 @@ namespace CBuild {
 
 		std::vector<std::filesystem::path> src_dirs;
 		std::vector<std::filesystem::path> src_files;
+		std::vector<std::string> src_globs;
+		std::vector<std::string> src_excludes;
 		std::vector<std::filesystem::path> incl_dirs;
+		std::vector<std::filesystem::path> external_incl_dirs; //Also part of incl_dirs, but only rescanned when the tree is replaced.
 		std::vector<std::filesystem::path> lib_dirs;
 		std::vector<std::string> static_libs;
 
 		bool run_binary = false;
 
-		std::vector<Checked_File> checked_files;
+		std::unordered_map<std::string, std::filesystem::path> obj_names; //Object path of each source below the obj output, relative to the source's root and without extension.
+
+		u64 build_file_hash = 0; //Digest of the build file contents, a build without it never takes the manifest fast path.
 
 		Parser();
 		~Parser();
@@ -96,26 +92,35 @@ namespace CBuild {
 		bool parse_cmd_set_run_binary(u64& _index, Token& _cur_token, Token& _prev_token);
 		bool parse_cmd_add_src_dirs(u64& _index, Token& _cur_token, Token& _prev_token);
 		bool parse_cmd_add_src_files(u64& _index, Token& _cur_token, Token& _prev_token);
+		bool parse_cmd_add_src_globs(u64& _index, Token& _cur_token, Token& _prev_token);
+		bool parse_cmd_add_src_excludes(u64& _index, Token& _cur_token, Token& _prev_token);
 		bool parse_cmd_add_incl_dirs(u64& _index, Token& _cur_token, Token& _prev_token);
+		bool parse_cmd_add_external_incl_dirs(u64& _index, Token& _cur_token, Token& _prev_token);
 		bool parse_cmd_add_lib_dirs(u64& _index, Token& _cur_token, Token& _prev_token);
 		bool parse_cmd_add_static_libs(u64& _index, Token& _cur_token, Token& _prev_token);
 
 		bool parse_cmd_add_dirs(u64& _index, Token& _cur_token, Token& _prev_token, std::vector<std::filesystem::path>& _dirs);
 		bool parse_cmd_add_files(u64& _index, Token& _cur_token, Token& _prev_token, std::vector<std::filesystem::path>& _files);
+		bool parse_cmd_add_globs(u64& _index, Token& _cur_token, Token& _prev_token, std::vector<std::string>& _globs);
 		bool parse_cmd_add_strings(u64& _index, Token& _cur_token, Token& _prev_token, std::vector<std::string>& _strings, bool _validate_strings = false);
 
-		bool parse_source_and_header_files(const std::filesystem::path& _path, Config_Type _config_type, const std::string& _compiler);
+		bool has_timestamp_changed(const std::filesystem::path& _path, Config_Type _config_type, u64 _time);
 
 		std::filesystem::path get_atmel_studio_include_path();
 		std::filesystem::path get_atmel_studio_mcu_path();
 		std::filesystem::path get_obj_output_path(Config_Type _config_type);
+		std::filesystem::path get_obj_path(const std::filesystem::path& _source, Config_Type _config_type, const std::string& _extension = ".o");
 		std::filesystem::path get_build_output_path(Config_Type _config_type);
 		std::filesystem::path get_compiler_path(const std::string _name);
 
+		std::filesystem::path get_config_path(const std::filesystem::path& _projects_path);
+		void load_build_config(const std::filesystem::path& _config_path);
+
+		bool find_source_files(std::vector<std::filesystem::path>& _files, u64* _listed_dirs = nullptr);
 		bool should_build();
-		bool build(const std::filesystem::path& _projects_path, bool _force_rebuild = false, bool _print_cmds = false, Config_Type _config_type = Config_Type::Debug);
-		bool build_gcc_clang(const std::string& _compiler, const std::filesystem::path& _projects_path, bool _force_rebuild = false, bool _print_cmds = false, Config_Type _config_type = Config_Type::Debug);
+		bool build(const std::filesystem::path& _projects_path, bool _force_rebuild = false, bool _print_cmds = false, Config_Type _config_type = Config_Type::Debug, u32 _job_count = 0, bool _print_stats = false, bool _hash_tokens = false, bool _explain = false);
+		bool build_gcc_clang(const std::string& _compiler, const std::filesystem::path& _projects_path, bool _force_rebuild = false, bool _print_cmds = false, Config_Type _config_type = Config_Type::Debug, u32 _job_count = 0, bool _print_stats = false, bool _hash_tokens = false, bool _explain = false);
 
 	};
 
-}
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "pch.h"
+#include "path_table.h"
+#include "file.h"
+
+namespace CBuild {
+
+	std::filesystem::path Path_Table::canonicalize(const std::filesystem::path& _path) {
+
+		//Different spellings of the same file, like 'src/../inc/a.h' and 'inc/a.h', get the same ID.
+		std::filesystem::path path = _path.lexically_normal();
+
+		//Absolute paths inside the project, from an absolute include dir or depfile entry, are made relative like the rest.
+		if (path.is_absolute()) {
+
+			std::filesystem::path relative = path.lexically_relative(get_root());
+			if (!relative.empty() && *relative.begin() != "..") path = relative;
+
+		}
+
+		File::format_path(path);
+
+		return path;
+
+	}
+
+	const std::filesystem::path& Path_Table::get_root() {
+
+		static const std::filesystem::path root = []() {
+
+			std::error_code error;
+			std::filesystem::path path = std::filesystem::current_path(error);
+
+			return error ? std::filesystem::path() : path.lexically_normal();
+
+		}();
+
+		return root;
+
+	}
+
+	Path_ID Path_Table::intern(const std::filesystem::path& _path) {
+
+		std::filesystem::path path = canonicalize(_path);
+		std::string key = path.string();
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		const auto& it = ids.find(key);
+		if (it != ids.end()) return it->second;
+
+		Path_ID id = (Path_ID)paths.size();
+
+		ids[key] = id;
+		paths.push_back(path);
+
+		return id;
+
+	}
+
+	bool Path_Table::find(const std::filesystem::path& _path, Path_ID& _id) {
+
+		std::string key = canonicalize(_path).string();
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		const auto& it = ids.find(key);
+		if (it == ids.end()) return false;
+
+		_id = it->second;
+		return true;
+
+	}
+
+	std::filesystem::path Path_Table::get_path(Path_ID _id) {
+
+		std::lock_guard<std::mutex> lock(mutex);
+		return paths[_id];
+
+	}
+
+	u64 Path_Table::size() {
+
+		std::lock_guard<std::mutex> lock(mutex);
+		return paths.size();
+
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <deque>
+#include <mutex>
+#include <filesystem>
+#include <unordered_map>
+
+#include "types.h"
+
+namespace CBuild {
+
+	typedef u32 Path_ID;
+
+	struct Path_Table {
+
+		std::mutex mutex;
+		std::unordered_map<std::string, Path_ID> ids;
+		std::deque<std::filesystem::path> paths;
+
+		static std::filesystem::path canonicalize(const std::filesystem::path& _path);
+		static const std::filesystem::path& get_root();
+
+		Path_ID intern(const std::filesystem::path& _path);
+		bool find(const std::filesystem::path& _path, Path_ID& _id);
+		std::filesystem::path get_path(Path_ID _id);
+		u64 size();
+
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,553 @@
+#include "pch.h"
+#include "preprocessor.h"
+#include "hash.h"
+
+#include <algorithm>
+
+namespace CBuild {
+
+	static const char* unknown_token = "@"; //Stands in for a value that can't be known without running the real preprocessor.
+
+	static inline bool is_identifier_start(char _char) {
+		return (_char == '_') || (_char >= 'A' && _char <= 'Z') || (_char >= 'a' && _char <= 'z');
+	}
+
+	static inline bool is_identifier_char(char _char) {
+		return is_identifier_start(_char) || (_char >= '0' && _char <= '9');
+	}
+
+	static bool skip_arguments(const std::vector<std::string>& _tokens, size_t& _index) {
+
+		//Expects _index to point at the opening parenthesis, leaves it at the closing one.
+		s32 depth = 0;
+
+		for (; _index < _tokens.size(); ++_index) {
+
+			if (_tokens[_index] == "(") ++depth;
+			else if (_tokens[_index] == ")" && --depth <= 0) return true;
+
+		}
+
+		return false;
+
+	}
+
+	static bool parse_number(const std::string& _token, s64& _result) {
+
+		std::string digits = _token;
+		while (!digits.empty() && (digits.back() == 'u' || digits.back() == 'U' || digits.back() == 'l' || digits.back() == 'L')) digits.pop_back();
+
+		if (digits.empty()) return false;
+
+		u32 base = 10;
+		size_t start = 0;
+
+		if (digits.length() > 2 && digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X')) { base = 16; start = 2; }
+		else if (digits.length() > 2 && digits[0] == '0' && (digits[1] == 'b' || digits[1] == 'B')) { base = 2; start = 2; }
+		else if (digits.length() > 1 && digits[0] == '0') { base = 8; start = 1; }
+
+		u64 value = 0;
+
+		for (size_t i = start; i < digits.length(); ++i) {
+
+			char c = digits[i];
+			u32 digit = 0;
+
+			if (c >= '0' && c <= '9') digit = (u32)(c - '0');
+			else if (c >= 'a' && c <= 'f') digit = (u32)(c - 'a' + 10);
+			else if (c >= 'A' && c <= 'F') digit = (u32)(c - 'A' + 10);
+			else if (c == '\'') continue;
+			else return false;
+
+			if (digit >= base) return false;
+			value = value * base + digit;
+
+		}
+
+		_result = (s64)value;
+		return true;
+
+	}
+
+	static bool parse_char(const std::string& _token, s64& _result) {
+
+		if (_token.length() < 3 || _token[0] != '\'' || _token.back() != '\'') return false;
+
+		if (_token.length() == 3) {
+
+			_result = (s64)(u8)_token[1];
+			return true;
+
+		}
+
+		if (_token.length() != 4 || _token[1] != '\\') return false;
+
+		switch (_token[2]) {
+
+			case 'n': _result = '\n'; return true;
+			case 't': _result = '\t'; return true;
+			case 'r': _result = '\r'; return true;
+			case '0': _result = 0; return true;
+			case '\\': _result = '\\'; return true;
+			case '\'': _result = '\''; return true;
+			case '"': _result = '"'; return true;
+
+		}
+
+		return false;
+
+	}
+
+	struct Expression_Parser {
+
+		const std::vector<std::string>& tokens;
+		size_t index = 0;
+		bool error = false;
+
+		Expression_Parser(const std::vector<std::string>& _tokens) : tokens(_tokens) {}
+
+		bool accept(const char* _token) {
+
+			if (index >= tokens.size() || tokens[index] != _token) return false;
+
+			++index;
+			return true;
+
+		}
+
+		static s32 get_precedence(const std::string& _op) {
+
+			if (_op == "||") return 1;
+			if (_op == "&&") return 2;
+			if (_op == "|") return 3;
+			if (_op == "^") return 4;
+			if (_op == "&") return 5;
+			if (_op == "==" || _op == "!=") return 6;
+			if (_op == "<" || _op == ">" || _op == "<=" || _op == ">=") return 7;
+			if (_op == "<<" || _op == ">>") return 8;
+			if (_op == "+" || _op == "-") return 9;
+			if (_op == "*" || _op == "/" || _op == "%") return 10;
+
+			return 0;
+
+		}
+
+		static Preprocessor_Value apply(const std::string& _op, Preprocessor_Value _lhs, Preprocessor_Value _rhs) {
+
+			//Logical operators can still be decided when only one side is known.
+			if (_op == "&&") {
+
+				if ((_lhs.known && _lhs.value == 0) || (_rhs.known && _rhs.value == 0)) return { 0, true };
+				if (_lhs.known && _rhs.known) return { 1, true };
+
+				return { 0, false };
+
+			}
+
+			if (_op == "||") {
+
+				if ((_lhs.known && _lhs.value != 0) || (_rhs.known && _rhs.value != 0)) return { 1, true };
+				if (_lhs.known && _rhs.known) return { 0, true };
+
+				return { 0, false };
+
+			}
+
+			if (!_lhs.known || !_rhs.known) return { 0, false };
+
+			s64 a = _lhs.value;
+			s64 b = _rhs.value;
+
+			if (_op == "|") return { a | b, true };
+			if (_op == "^") return { a ^ b, true };
+			if (_op == "&") return { a & b, true };
+			if (_op == "==") return { a == b, true };
+			if (_op == "!=") return { a != b, true };
+			if (_op == "<") return { a < b, true };
+			if (_op == ">") return { a > b, true };
+			if (_op == "<=") return { a <= b, true };
+			if (_op == ">=") return { a >= b, true };
+			if (_op == "+") return { (s64)((u64)a + (u64)b), true };
+			if (_op == "-") return { (s64)((u64)a - (u64)b), true };
+			if (_op == "*") return { (s64)((u64)a * (u64)b), true };
+
+			if (_op == "<<" || _op == ">>") {
+
+				if (b < 0 || b >= 64) return { 0, false };
+				return { (_op == "<<") ? (s64)((u64)a << b) : (a >> b), true };
+
+			}
+
+			if (b == 0) return { 0, false };
+			if (b == -1) return { (_op == "/") ? (s64)(0 - (u64)a) : 0, true };
+
+			return { (_op == "/") ? a / b : a % b, true };
+
+		}
+
+		Preprocessor_Value parse_conditional() {
+
+			Preprocessor_Value condition = parse_binary(1);
+			if (!accept("?")) return condition;
+
+			Preprocessor_Value if_true = parse_conditional();
+			if (!accept(":")) error = true;
+			Preprocessor_Value if_false = parse_conditional();
+
+			if (condition.known) return (condition.value != 0) ? if_true : if_false;
+			if (if_true.known && if_false.known && if_true.value == if_false.value) return if_true;
+
+			return { 0, false };
+
+		}
+
+		Preprocessor_Value parse_binary(s32 _min_precedence) {
+
+			Preprocessor_Value lhs = parse_unary();
+
+			while (!error && index < tokens.size()) {
+
+				std::string op = tokens[index];
+
+				s32 precedence = get_precedence(op);
+				if (precedence <= 0 || precedence < _min_precedence) break;
+
+				++index;
+
+				Preprocessor_Value rhs = parse_binary(precedence + 1);
+				lhs = apply(op, lhs, rhs);
+
+			}
+
+			return lhs;
+
+		}
+
+		Preprocessor_Value parse_unary() {
+
+			if (accept("!")) {
+
+				Preprocessor_Value value = parse_unary();
+				return { value.value == 0, value.known };
+
+			}
+
+			if (accept("-")) {
+
+				Preprocessor_Value value = parse_unary();
+				return { (s64)(0 - (u64)value.value), value.known };
+
+			}
+
+			if (accept("~")) {
+
+				Preprocessor_Value value = parse_unary();
+				return { ~value.value, value.known };
+
+			}
+
+			if (accept("+")) return parse_unary();
+
+			return parse_primary();
+
+		}
+
+		Preprocessor_Value parse_primary() {
+
+			if (index >= tokens.size()) {
+
+				error = true;
+				return { 0, false };
+
+			}
+
+			if (accept("(")) {
+
+				Preprocessor_Value value = parse_conditional();
+				if (!accept(")")) error = true;
+
+				return value;
+
+			}
+
+			const std::string& token = tokens[index++];
+			s64 value = 0;
+
+			if (token == unknown_token) return { 0, false };
+			if (token[0] >= '0' && token[0] <= '9' && parse_number(token, value)) return { value, true };
+			if (token[0] == '\'' && parse_char(token, value)) return { value, true };
+
+			error = true;
+			return { 0, false };
+
+		}
+
+	};
+
+	void Preprocessor::define(const std::string& _name, const std::string& _value, bool _function_like) {
+
+		if (record) accesses.push_back({ _name, 0, true });
+
+		Macro& macro = macros[_name];
+
+		macro.state = Macro_State::Defined;
+		macro.value = _value;
+		macro.value_known = true;
+		macro.function_like = _function_like;
+
+	}
+
+	void Preprocessor::define_unknown(const std::string& _name) {
+
+		if (record) accesses.push_back({ _name, 0, true });
+
+		Macro& macro = macros[_name];
+
+		macro.state = Macro_State::Defined;
+		macro.value.clear();
+		macro.value_known = false;
+		macro.function_like = false;
+
+	}
+
+	void Preprocessor::undefine(const std::string& _name) {
+
+		if (record) accesses.push_back({ _name, 0, true });
+		macros[_name] = { Macro_State::Undefined };
+
+	}
+
+	void Preprocessor::forget(const std::string& _name) {
+
+		if (record) accesses.push_back({ _name, 0, true });
+		macros[_name] = { Macro_State::Unknown };
+
+	}
+
+	Macro_State Preprocessor::get_state(const std::string& _name) {
+
+		if (record) accesses.push_back({ _name, get_digest(_name), false });
+
+		const auto& it = macros.find(_name);
+		if (it != macros.end()) return it->second.state;
+
+		//Reserved names belong to the compiler and the system headers, which are never read.
+		if (is_reserved(_name) || !assume_undefined) return Macro_State::Unknown;
+
+		return Macro_State::Undefined;
+
+	}
+
+	u64 Preprocessor::get_digest(const std::string& _name) const {
+
+		//Everything a read of the macro can see, a name that isn't in the table depends on what unknown names are assumed to be.
+		const auto& it = macros.find(_name);
+		if (it == macros.end()) return (is_reserved(_name) || !assume_undefined) ? 1 : 2;
+
+		const Macro& macro = it->second;
+		u64 flags = ((u64)macro.state << 2) | ((u64)macro.value_known << 1) | (u64)macro.function_like;
+
+		return Hash::combine(Hash::string(macro.value), flags);
+
+	}
+
+	bool Preprocessor::is_reserved(const std::string& _name) {
+		return _name.length() >= 2 && _name[0] == '_' && (_name[1] == '_' || (_name[1] >= 'A' && _name[1] <= 'Z'));
+	}
+
+	void Preprocessor::tokenize(const std::string& _text, std::vector<std::string>& _tokens) {
+
+		size_t length = _text.length();
+		size_t i = 0;
+
+		while (i < length) {
+
+			char cur = _text[i];
+			size_t start = i;
+
+			if (isspace((u8)cur)) {
+
+				++i;
+				continue;
+
+			}
+
+			if (is_identifier_start(cur)) {
+				for (++i; i < length && is_identifier_char(_text[i]); ++i);
+			}
+			else if ((cur >= '0' && cur <= '9') || (cur == '.' && i + 1 < length && _text[i + 1] >= '0' && _text[i + 1] <= '9')) {
+
+				for (++i; i < length; ++i) {
+
+					char c = _text[i];
+					if ((c == '+' || c == '-') && (_text[i - 1] == 'e' || _text[i - 1] == 'E' || _text[i - 1] == 'p' || _text[i - 1] == 'P')) continue;
+					if (!is_identifier_char(c) && c != '.' && c != '\'') break;
+
+				}
+
+			}
+			else if (cur == '\'' || cur == '"') {
+
+				for (++i; i < length && _text[i] != cur; ++i) {
+					if (_text[i] == '\\') ++i;
+				}
+
+				i = std::min(i + 1, length);
+
+			}
+			else {
+
+				static const char* operators[] = { "&&", "||", "==", "!=", "<=", ">=", "<<", ">>", "##" };
+
+				++i;
+
+				for (const char* op : operators) {
+
+					if (i < length && cur == op[0] && _text[i] == op[1]) {
+
+						++i;
+						break;
+
+					}
+
+				}
+
+			}
+
+			_tokens.push_back(_text.substr(start, i - start));
+
+		}
+
+	}
+
+	bool Preprocessor::expand(const std::string& _text, std::vector<std::string>& _tokens, u32 _depth, std::vector<std::string>& _active, bool _condition) {
+
+		std::vector<std::string> raw;
+		tokenize(_text, raw);
+
+		for (size_t i = 0; i < raw.size(); ++i) {
+
+			const std::string& token = raw[i];
+
+			if (!is_identifier_start(token[0])) {
+
+				_tokens.push_back(token);
+				continue;
+
+			}
+
+			if (_condition && token == "defined") {
+
+				size_t j = i + 1;
+
+				bool parenthesized = (j < raw.size() && raw[j] == "(");
+				if (parenthesized) ++j;
+
+				if (j >= raw.size() || !is_identifier_start(raw[j][0])) return false;
+
+				Macro_State state = get_state(raw[j]);
+
+				if (parenthesized && (++j >= raw.size() || raw[j] != ")")) return false;
+				i = j;
+
+				_tokens.push_back((state == Macro_State::Defined) ? "1" : (state == Macro_State::Undefined) ? "0" : unknown_token);
+				continue;
+
+			}
+
+			bool call = (i + 1 < raw.size() && raw[i + 1] == "(");
+			bool active = std::find(_active.begin(), _active.end(), token) != _active.end();
+
+			const auto& it = macros.find(token);
+			Macro_State state = get_state(token);
+
+			//A macro that refers to itself stays an identifier, which evaluates to 0.
+			if (state == Macro_State::Defined && !active && !it->second.function_like) {
+
+				if (!it->second.value_known || _depth >= 64) {
+
+					_tokens.push_back(unknown_token);
+					continue;
+
+				}
+
+				_active.push_back(token);
+				bool expanded = expand(it->second.value, _tokens, _depth + 1, _active, _condition);
+				_active.pop_back();
+
+				if (!expanded) return false;
+				continue;
+
+			}
+
+			//Calls like __has_include(...) or function-like macros are not evaluated.
+			if (call) {
+
+				++i;
+				if (!skip_arguments(raw, i)) return false;
+
+				_tokens.push_back(unknown_token);
+				continue;
+
+			}
+
+			//Outside of conditions, names that aren't macros are kept as they are, like the parts of <dir/file.h>.
+			if (state == Macro_State::Unknown && !active) _tokens.push_back(unknown_token);
+			else _tokens.push_back(_condition ? "0" : token);
+
+		}
+
+		return true;
+
+	}
+
+	Condition Preprocessor::evaluate(const std::string& _expression) {
+
+		std::vector<std::string> tokens;
+		std::vector<std::string> active;
+
+		if (!expand(_expression, tokens, 0, active) || tokens.empty()) return Condition::Unknown;
+
+		Expression_Parser parser(tokens);
+		Preprocessor_Value value = parser.parse_conditional();
+
+		if (parser.error || parser.index < tokens.size() || !value.known) return Condition::Unknown;
+
+		return (value.value != 0) ? Condition::True : Condition::False;
+
+	}
+
+	bool Preprocessor::expand_include(const std::string& _text, std::string& _name, bool& _angled) {
+
+		//Only object-like macros that expand to "file" or <file> can be followed.
+		std::vector<std::string> tokens;
+		std::vector<std::string> active;
+
+		if (!expand(_text, tokens, 0, active, false) || tokens.empty()) return false;
+
+		if (tokens.size() == 1 && tokens[0].length() >= 2 && tokens[0].front() == '"' && tokens[0].back() == '"') {
+
+			_name = tokens[0].substr(1, tokens[0].length() - 2);
+			_angled = false;
+
+			return !_name.empty();
+
+		}
+
+		if (tokens.size() < 3 || tokens.front() != "<" || tokens.back() != ">") return false;
+
+		_name.clear();
+
+		for (size_t i = 1; i < tokens.size() - 1; ++i) {
+
+			if (tokens[i] == unknown_token) return false;
+			_name += tokens[i];
+
+		}
+
+		_angled = true;
+		return true;
+
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "types.h"
+
+namespace CBuild {
+
+	enum class Macro_State : u8 {
+
+		Unknown,
+		Defined,
+		Undefined,
+
+	};
+
+	enum class Condition : u8 {
+
+		False,
+		True,
+		Unknown,
+
+	};
+
+	struct Macro {
+
+		Macro_State state = Macro_State::Unknown;
+		std::string value = "";
+		bool value_known = true; //Predefined by the compiler, but the exact value isn't known.
+		bool function_like = false;
+
+	};
+
+	struct Macro_Access {
+
+		std::string name = "";
+		u64 digest = 0; //What a read saw, see get_digest.
+		bool write = false;
+
+	};
+
+	struct Preprocessor_Value {
+
+		s64 value = 0;
+		bool known = true;
+
+	};
+
+	struct Preprocessor {
+
+		//Tracks macros while walking a translation unit, a condition that depends on anything unknown is treated as maybe taken.
+		std::unordered_map<std::string, Macro> macros;
+		bool assume_undefined = true; //Macros that haven't been defined so far are undefined, until an include couldn't be followed.
+		bool record = false; //Log every read and write to accesses.
+		std::vector<Macro_Access> accesses;
+
+		void define(const std::string& _name, const std::string& _value, bool _function_like = false);
+		void define_unknown(const std::string& _name);
+		void undefine(const std::string& _name);
+		void forget(const std::string& _name);
+		Macro_State get_state(const std::string& _name);
+		u64 get_digest(const std::string& _name) const;
+		Condition evaluate(const std::string& _expression);
+		bool expand_include(const std::string& _text, std::string& _name, bool& _angled);
+
+		static bool is_reserved(const std::string& _name);
+		bool expand(const std::string& _text, std::vector<std::string>& _tokens, u32 _depth, std::vector<std::string>& _active, bool _condition = true);
+		static void tokenize(const std::string& _text, std::vector<std::string>& _tokens);
+
+	};
+
+}
\ No newline at end of file
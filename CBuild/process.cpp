@@ -0,0 +1,128 @@
+#include "pch.h"
+#include "process.h"
+
+#include <chrono>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <spawn.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+extern char** environ;
+#endif
+
+namespace CBuild {
+
+	bool Process::run(const std::vector<std::string>& _args, Process_Result& _result) {
+
+		_result = {};
+		if (_args.empty()) return false;
+
+		auto start = std::chrono::steady_clock::now();
+
+#ifdef _WIN32
+
+		//cmd.exe strips the outer quotes, the quoted arguments inside are kept as they are.
+		std::string cmd = "\"" + args_to_string(_args) + "\"";
+
+		_result.started = true;
+		_result.exit_code = system(cmd.c_str());
+
+#else
+
+		//Spawn the tool directly from an argv vector, no shell is involved.
+		std::vector<char*> argv;
+		argv.reserve(_args.size() + 1);
+
+		for (const std::string& arg : _args) {
+			argv.push_back(const_cast<char*>(arg.c_str()));
+		}
+
+		argv.push_back(nullptr);
+
+		pid_t pid = 0;
+		int error = posix_spawnp(&pid, argv[0], nullptr, nullptr, argv.data(), environ);
+
+		if (error != 0) {
+
+			CBUILD_ERROR("Unable to start '{}': {}", _args[0], strerror(error));
+			return false;
+
+		}
+
+		_result.started = true;
+
+		int status = 0;
+		struct rusage usage = {};
+
+		while (wait4(pid, &status, 0, &usage) < 0) {
+
+			if (errno != EINTR) {
+
+				CBUILD_ERROR("Unable to wait for '{}': {}", _args[0], strerror(errno));
+				return false;
+
+			}
+
+		}
+
+		if (WIFEXITED(status)) _result.exit_code = WEXITSTATUS(status);
+		else if (WIFSIGNALED(status)) _result.exit_code = 128 + WTERMSIG(status);
+
+		_result.user_time = (u64)usage.ru_utime.tv_sec * 1000000 + (u64)usage.ru_utime.tv_usec;
+		_result.system_time = (u64)usage.ru_stime.tv_sec * 1000000 + (u64)usage.ru_stime.tv_usec;
+		_result.max_rss = (u64)usage.ru_maxrss;
+
+#endif
+
+		_result.wall_time = (u64)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+		return (_result.exit_code == 0);
+
+	}
+
+	void Process_Result::add(const Process_Result& _result) {
+
+		//A job that runs more than one tool reports their usage together, the exit code stays the one of its main tool.
+		wall_time += _result.wall_time;
+		user_time += _result.user_time;
+		system_time += _result.system_time;
+		max_rss = std::max(max_rss, _result.max_rss);
+
+	}
+
+	bool Process::run(const std::vector<std::string>& _args) {
+
+		Process_Result result;
+		return run(_args, result);
+
+	}
+
+	std::string Process::args_to_string(const std::vector<std::string>& _args) {
+
+		std::string cmd;
+
+		for (u64 i = 0; i < _args.size(); ++i) {
+
+			const std::string& arg = _args[i];
+
+			if (i > 0) cmd += " ";
+
+			//The executable is always quoted, other arguments only when they need it.
+			if (i == 0 || arg.empty() || arg.find_first_of(" \t\"'&|;<>()$`\\*?") != std::string::npos) {
+				cmd += "\"" + arg + "\"";
+			}
+			else {
+				cmd += arg;
+			}
+
+		}
+
+		return cmd;
+
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+namespace CBuild {
+
+	struct Process_Result {
+
+		bool started = false;
+		s32 exit_code = -1;
+
+		u64 wall_time = 0; //Microseconds.
+		u64 user_time = 0; //Microseconds.
+		u64 system_time = 0; //Microseconds.
+		u64 max_rss = 0; //Kilobytes.
+
+		void add(const Process_Result& _result);
+
+	};
+
+	struct Process {
+
+		static bool run(const std::vector<std::string>& _args, Process_Result& _result);
+		static bool run(const std::vector<std::string>& _args);
+		static std::string args_to_string(const std::vector<std::string>& _args);
+
+	};
+
+}
\ No newline at end of file
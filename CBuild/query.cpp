@@ -0,0 +1,61 @@
+#include "pch.h"
+#include "query.h"
+#include "parser.h"
+#include "path_table.h"
+
+#include <algorithm>
+
+namespace CBuild {
+
+	bool Query::run(Parser& _parser, const std::filesystem::path& _projects_path, Config_Type _config_type, const std::vector<std::string>& _args) {
+
+		if (_args.size() < 2) {
+
+			CBUILD_ERROR("Usage: cbuild query rdeps <file> [build file]");
+			return false;
+
+		}
+
+		//Queries answer from the state of the last build, nothing is scanned.
+		_parser.load_build_config(_parser.get_config_path(_projects_path));
+
+		if (_args[0] == "rdeps") return rdeps(_parser, _config_type, std::filesystem::u8path(_args[1]));
+
+		CBUILD_ERROR("Unknown query '{}'. (supports: rdeps)", _args[0]);
+		return false;
+
+	}
+
+	bool Query::rdeps(Parser& _parser, Config_Type _config_type, const std::filesystem::path& _file) {
+
+		if (_parser.config.get_config_timestamps(_config_type) == nullptr) {
+
+			CBUILD_ERROR("No {} build of '{}' found, build it first.", _parser.config.config_type_to_string(_config_type), _parser.project_name);
+			return false;
+
+		}
+
+		std::filesystem::path path = Path_Table::canonicalize(_file);
+
+		const std::vector<std::string>* dependents = _parser.config.get_config_dependents(_config_type, path);
+
+		if (dependents == nullptr) {
+
+			CBUILD_TRACE("No sources depend on '{}'.", path.string());
+			return true;
+
+		}
+
+		std::vector<std::string> sources = *dependents;
+		std::sort(sources.begin(), sources.end());
+
+		//Plain lines on stdout, so the list can be piped into other tools.
+		for (const std::string& source : sources) {
+			printf("%s\n", source.c_str());
+		}
+
+		return true;
+
+	}
+
+}
\ No newline at end of file
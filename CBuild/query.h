@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "types.h"
+#include "config.h"
+
+namespace CBuild {
+
+	struct Parser;
+
+	struct Query {
+
+		static bool run(Parser& _parser, const std::filesystem::path& _projects_path, Config_Type _config_type, const std::vector<std::string>& _args);
+		static bool rdeps(Parser& _parser, Config_Type _config_type, const std::filesystem::path& _file);
+
+	};
+
+}
\ No newline at end of file
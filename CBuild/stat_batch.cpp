@@ -0,0 +1,307 @@
+#include "pch.h"
+#include "stat_batch.h"
+
+#include <algorithm>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define CBUILD_IO_URING
+#endif
+#endif
+
+#ifdef CBUILD_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+namespace CBuild {
+
+#ifdef CBUILD_IO_URING
+
+	//Minimal io_uring setup over the raw system calls, so no liburing is needed.
+	struct Io_Uring {
+
+		int fd = -1;
+		u32 entries = 0;
+
+		void* sq_ring = MAP_FAILED;
+		void* cq_ring = MAP_FAILED;
+		u64 sq_ring_size = 0;
+		u64 cq_ring_size = 0;
+		io_uring_sqe* sqes = (io_uring_sqe*)MAP_FAILED;
+		u64 sqes_size = 0;
+
+		u32* sq_tail = nullptr;
+		u32* sq_mask = nullptr;
+		u32* sq_array = nullptr;
+		u32* cq_head = nullptr;
+		u32* cq_tail = nullptr;
+		u32* cq_mask = nullptr;
+		io_uring_cqe* cqes = nullptr;
+
+		bool setup(u32 _entries) {
+
+			io_uring_params params;
+			memset(&params, 0, sizeof(params));
+
+			fd = (int)syscall(__NR_io_uring_setup, _entries, &params);
+			if (fd < 0) return false;
+
+			entries = params.sq_entries;
+
+			sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+			cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+			//Newer kernels map both rings with a single call.
+			bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+			if (single_mmap) sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+
+			sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+			if (sq_ring == MAP_FAILED) return false;
+
+			if (single_mmap) cq_ring = sq_ring;
+			else {
+
+				cq_ring = mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+				if (cq_ring == MAP_FAILED) return false;
+
+			}
+
+			sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+			sqes = (io_uring_sqe*)mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+			if (sqes == MAP_FAILED) return false;
+
+			sq_tail = (u32*)((u8*)sq_ring + params.sq_off.tail);
+			sq_mask = (u32*)((u8*)sq_ring + params.sq_off.ring_mask);
+			sq_array = (u32*)((u8*)sq_ring + params.sq_off.array);
+			cq_head = (u32*)((u8*)cq_ring + params.cq_off.head);
+			cq_tail = (u32*)((u8*)cq_ring + params.cq_off.tail);
+			cq_mask = (u32*)((u8*)cq_ring + params.cq_off.ring_mask);
+			cqes = (io_uring_cqe*)((u8*)cq_ring + params.cq_off.cqes);
+
+			return true;
+
+		}
+
+		~Io_Uring() {
+
+			if (sqes != MAP_FAILED) munmap(sqes, sqes_size);
+			if (cq_ring != MAP_FAILED && cq_ring != sq_ring) munmap(cq_ring, cq_ring_size);
+			if (sq_ring != MAP_FAILED) munmap(sq_ring, sq_ring_size);
+			if (fd >= 0) close(fd);
+
+		}
+
+		void queue_statx(const char* _path, struct statx* _result, u64 _user_data) {
+
+			u32 tail = *sq_tail;
+			u32 index = tail & *sq_mask;
+
+			io_uring_sqe* sqe = &sqes[index];
+			memset(sqe, 0, sizeof(io_uring_sqe));
+
+			sqe->opcode = IORING_OP_STATX;
+			sqe->fd = AT_FDCWD;
+			sqe->addr = (u64)(uintptr_t)_path;
+			sqe->len = STATX_TYPE | STATX_MTIME | STATX_SIZE;
+			sqe->off = (u64)(uintptr_t)_result;
+			sqe->statx_flags = 0;
+			sqe->user_data = _user_data;
+
+			sq_array[index] = index;
+
+			//The kernel may only see the new tail once the entry has been written.
+			__atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+		}
+
+		bool submit_and_wait(u32 _count) {
+
+			u32 submitted = 0;
+
+			while (submitted < _count) {
+
+				int result = (int)syscall(__NR_io_uring_enter, fd, _count - submitted, _count - submitted, IORING_ENTER_GETEVENTS, nullptr, 0);
+
+				if (result < 0) {
+
+					if (errno == EINTR) continue;
+					return false;
+
+				}
+
+				submitted += (u32)result;
+
+			}
+
+			return true;
+
+		}
+
+	};
+
+	static void statx_to_file_info(const struct statx& _result, File_Info& _info) {
+
+		_info.exists = true;
+		_info.is_directory = S_ISDIR(_result.stx_mode);
+		_info.size = (u64)_result.stx_size;
+		_info.time = (u64)_result.stx_mtime.tv_sec * 1000000000ull + (u64)_result.stx_mtime.tv_nsec;
+
+	}
+
+#endif
+
+	const char* Stat_Batch::method_to_string(Stat_Method _method) {
+
+		switch (_method) {
+
+			case Stat_Method::Sequential: return "sequential";
+			case Stat_Method::Thread_Pool: return "thread pool";
+			case Stat_Method::Io_Uring: return "io_uring";
+
+		}
+
+		return "";
+
+	}
+
+	bool Stat_Batch::io_uring_available() {
+
+#ifdef CBUILD_IO_URING
+		//Setup fails on kernels without io_uring, and where seccomp or a sysctl disables it.
+		Io_Uring ring;
+		return ring.setup(1);
+#else
+		return false;
+#endif
+
+	}
+
+	Stat_Method Stat_Batch::stat_all(const std::vector<std::filesystem::path>& _paths, std::vector<File_Info>& _infos, Job_Pool& _job_pool) {
+
+		//Setting up a ring costs about as much as a few hundred warm stat calls, so it only pays off for bigger batches.
+		//On cold caches and network file systems every stat can block, and the ring keeps all of them in flight at once
+		//without tying up the scan jobs.
+		if (_paths.size() < batch_size) {
+
+			stat_sequential(_paths, _infos);
+			return Stat_Method::Sequential;
+
+		}
+
+		if (stat_io_uring(_paths, _infos)) return Stat_Method::Io_Uring;
+
+		stat_thread_pool(_paths, _infos, _job_pool);
+		return Stat_Method::Thread_Pool;
+
+	}
+
+	void Stat_Batch::stat_sequential(const std::vector<std::filesystem::path>& _paths, std::vector<File_Info>& _infos) {
+
+		_infos.resize(_paths.size());
+
+		for (u64 i = 0; i < _paths.size(); ++i) {
+			File::get_info(_paths[i], _infos[i]);
+		}
+
+	}
+
+	void Stat_Batch::stat_thread_pool(const std::vector<std::filesystem::path>& _paths, std::vector<File_Info>& _infos, Job_Pool& _job_pool) {
+
+		_infos.resize(_paths.size());
+
+		//Every job writes its own slice of the results, so they don't need a lock.
+		for (u64 start = 0; start < _paths.size(); start += batch_size) {
+
+			u64 end = std::min<u64>(start + batch_size, _paths.size());
+
+			_job_pool.submit("", [&_paths, &_infos, start, end]() {
+
+				for (u64 i = start; i < end; ++i) {
+					File::get_info(_paths[i], _infos[i]);
+				}
+
+				return true;
+
+			});
+
+		}
+
+		_job_pool.wait();
+
+	}
+
+	bool Stat_Batch::stat_io_uring(const std::vector<std::filesystem::path>& _paths, std::vector<File_Info>& _infos) {
+
+#ifdef CBUILD_IO_URING
+		//The results have to outlive the ring, closing it waits for requests that are still in flight.
+		std::vector<struct statx> results(batch_size);
+
+		Io_Uring ring;
+		if (!ring.setup(batch_size)) return false;
+		if (ring.entries > results.size()) results.resize(ring.entries);
+
+		_infos.assign(_paths.size(), File_Info());
+
+		for (u64 start = 0; start < _paths.size(); start += ring.entries) {
+
+			u32 count = (u32)std::min<u64>(ring.entries, _paths.size() - start);
+
+			for (u32 i = 0; i < count; ++i) {
+				ring.queue_statx(_paths[start + i].c_str(), &results[i], i);
+			}
+
+			if (!ring.submit_and_wait(count)) {
+
+				//Whatever is left falls back to plain stat calls.
+				for (u64 i = start; i < _paths.size(); ++i) {
+					File::get_info(_paths[i], _infos[i]);
+				}
+
+				return true;
+
+			}
+
+			u32 head = *ring.cq_head;
+			u32 tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+
+			for (u32 reaped = 0; reaped < count; ) {
+
+				if (head == tail) {
+
+					//Completions can trail behind the submit call, wait for the rest.
+					syscall(__NR_io_uring_enter, ring.fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+					tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+					continue;
+
+				}
+
+				const io_uring_cqe& cqe = ring.cqes[head & *ring.cq_mask];
+				u64 index = start + cqe.user_data;
+
+				if (cqe.res == 0) statx_to_file_info(results[cqe.user_data], _infos[index]);
+				else if (cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP) File::get_info(_paths[index], _infos[index]); //Kernels before 5.6 have no statx opcode.
+
+				++head;
+				++reaped;
+
+			}
+
+			__atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+
+		}
+
+		return true;
+#else
+		return false;
+#endif
+
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+#include <filesystem>
+
+#include "types.h"
+#include "file.h"
+#include "job_pool.h"
+
+namespace CBuild {
+
+	enum class Stat_Method : u8 {
+
+		Sequential,
+		Thread_Pool,
+		Io_Uring, //Linux only, statx requests are queued on a ring and completed by the kernel in batches.
+
+	};
+
+	struct Stat_Batch {
+
+		static constexpr u32 batch_size = 256;
+
+		static const char* method_to_string(Stat_Method _method);
+		static bool io_uring_available();
+
+		static Stat_Method stat_all(const std::vector<std::filesystem::path>& _paths, std::vector<File_Info>& _infos, Job_Pool& _job_pool);
+		static void stat_sequential(const std::vector<std::filesystem::path>& _paths, std::vector<File_Info>& _infos);
+		static void stat_thread_pool(const std::vector<std::filesystem::path>& _paths, std::vector<File_Info>& _infos, Job_Pool& _job_pool);
+		static bool stat_io_uring(const std::vector<std::filesystem::path>& _paths, std::vector<File_Info>& _infos);
+
+	};
+
+}
\ No newline at end of file
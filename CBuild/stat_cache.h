@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <filesystem>
+#include <unordered_map>
+
+#include "types.h"
+#include "path_table.h"
+
+namespace CBuild {
+
+	struct Stat_Cache {
+
+		//Remembers whether a file exists for the rest of the run, missing files are cached as well.
+		std::mutex mutex;
+		std::vector<std::unordered_map<std::string, bool>> dirs; //Indexed by directory path ID, keyed by the name relative to it.
+
+		u64 probes = 0;
+		u64 stat_calls = 0;
+		u64 saved_calls = 0;
+		u64 negative_hits = 0;
+
+		bool file_exists(Path_ID _dir, const std::filesystem::path& _path, const std::string& _name);
+		void print_stats();
+
+	};
+
+}
\ No newline at end of file
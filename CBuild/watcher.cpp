@@ -0,0 +1,235 @@
+#include "pch.h"
+#include "watcher.h"
+#include "parser.h"
+#include "lexer.h"
+#include "path_table.h"
+#include "hash.h"
+
+#include <cerrno>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace CBuild {
+
+	//Events that arrive this close together are one save, a checkout or a formatter run.
+	static const int debounce_ms = 10;
+
+	Watcher::~Watcher() {
+
+#ifdef __linux__
+		if (inotify_fd >= 0) close(inotify_fd);
+#endif
+
+	}
+
+	bool Watcher::run(Parser& _parser, bool _force_rebuild) {
+
+#ifndef __linux__
+		CBUILD_ERROR("Watch mode is only supported on Linux.");
+		return false;
+#else
+		inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+		if (inotify_fd < 0) {
+
+			CBUILD_ERROR("Unable to initialize inotify.");
+			return false;
+
+		}
+
+		//The parser and the config it loads stay in memory, so a rebuild starts with the dependency scan.
+		parser = &_parser;
+		parser->build(projects_path, _force_rebuild, print_cmds, config_type, job_count, print_stats, hash_tokens, explain);
+
+		while (true) {
+
+			add_watches();
+			CBUILD_TRACE("Watching for changes...");
+
+			bool build_file_changed = false;
+			if (!wait_for_changes(build_file_changed)) return false;
+
+			if (build_file_changed && !reload_build_file()) continue;
+
+			parser->build(projects_path, false, print_cmds, config_type, job_count, print_stats, hash_tokens, explain);
+
+		}
+#endif
+
+	}
+
+	bool Watcher::reload_build_file() {
+
+		std::string source;
+
+		if (!File::read_text_file(build_file, source)) {
+
+			CBUILD_ERROR("Error reading input file.");
+			return false;
+
+		}
+
+		Lexer lexer;
+		lexer.parse_source(source);
+
+		if (lexer.error_handler.has_error()) {
+
+			CBUILD_ERROR(lexer.error_handler.get_error_message());
+			return false;
+
+		}
+
+		std::unique_ptr<Parser> new_parser = std::make_unique<Parser>();
+		new_parser->parse_tokens(&lexer);
+		new_parser->build_file_hash = Hash::string(source);
+
+		if (new_parser->error_handler.has_error()) {
+
+			CBUILD_ERROR(new_parser->error_handler.get_error_message());
+			return false;
+
+		}
+
+		if (!new_parser->should_build()) {
+
+			CBUILD_TRACE("Nothing to build.");
+			return false;
+
+		}
+
+		reloaded_parser = std::move(new_parser);
+		parser = reloaded_parser.get();
+
+		return true;
+
+	}
+
+	void Watcher::add_watches() {
+
+		//Every directory that was walked for sources or holds a file the last build depended on.
+		add_watch(build_file.has_parent_path() ? build_file.parent_path() : std::filesystem::path());
+
+		for (const auto& listing_it : parser->config.dir_listings) {
+			add_watch(std::filesystem::u8path(listing_it.first));
+		}
+
+		for (const std::filesystem::path& incl_dir : parser->incl_dirs) {
+			add_watch(incl_dir);
+		}
+
+		for (const auto& config_it : parser->config.configs) {
+
+			for (const auto& timestamp_it : config_it.second.timestamps) {
+
+				std::filesystem::path path = std::filesystem::u8path(timestamp_it.first);
+				add_watch(path.has_parent_path() ? path.parent_path() : std::filesystem::path());
+
+			}
+
+		}
+
+	}
+
+	void Watcher::add_watch(const std::filesystem::path& _dir) {
+
+#ifdef __linux__
+		std::string key = _dir.string();
+		if (watched_dirs.find(key) != watched_dirs.end()) return;
+
+		std::string dir = _dir.empty() ? "." : key;
+		int watch = inotify_add_watch(inotify_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE);
+
+		if (watch < 0) {
+
+			CBUILD_WARN("Unable to watch directory '{}'.", dir);
+			watched_dirs[key] = -1;
+
+			return;
+
+		}
+
+		watches[watch] = _dir;
+		watched_dirs[key] = watch;
+#endif
+
+	}
+
+	bool Watcher::wait_for_changes(bool& _build_file_changed) {
+
+#ifndef __linux__
+		return false;
+#else
+		alignas(inotify_event) char buffer[16384];
+
+		pollfd poll_fd = { inotify_fd, POLLIN, 0 };
+		bool changed = false;
+
+		//Block until the first relevant event, then keep draining until the directory has been quiet for a moment.
+		while (true) {
+
+			int ready = poll(&poll_fd, 1, changed ? debounce_ms : -1);
+
+			if (ready < 0) {
+
+				if (errno == EINTR) continue;
+
+				CBUILD_ERROR("Error waiting for file changes.");
+				return false;
+
+			}
+
+			if (ready == 0) return true;
+
+			ssize_t length = read(inotify_fd, buffer, sizeof(buffer));
+			if (length <= 0) continue;
+
+			for (char* ptr = buffer; ptr < buffer + length; ptr += sizeof(inotify_event) + ((inotify_event*)ptr)->len) {
+
+				const inotify_event* event = (const inotify_event*)ptr;
+
+				const auto& it = watches.find(event->wd);
+				if (it == watches.end() || event->len <= 0) continue;
+
+				std::filesystem::path path = it->second / std::filesystem::u8path(event->name);
+				File::format_path(path);
+
+				if (Path_Table::canonicalize(path) == Path_Table::canonicalize(build_file)) {
+
+					_build_file_changed = true;
+					changed = true;
+
+				}
+				else if (is_relevant(path, (event->mask & IN_ISDIR) != 0)) {
+					changed = true;
+				}
+
+			}
+
+		}
+#endif
+
+	}
+
+	bool Watcher::is_relevant(const std::filesystem::path& _path, bool _is_dir) {
+
+		//Editors write swap and backup files next to the sources, those shouldn't start a build.
+		if (_is_dir) return true;
+
+		std::string extension = _path.extension().string();
+		if (extension == ".c" || extension == ".h") return true;
+
+		std::string path = Path_Table::canonicalize(_path).string();
+
+		for (const auto& config_it : parser->config.configs) {
+			if (config_it.second.timestamps.find(path) != config_it.second.timestamps.end()) return true;
+		}
+
+		return false;
+
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <filesystem>
+#include <unordered_map>
+
+#include "types.h"
+#include "config.h"
+
+namespace CBuild {
+
+	struct Parser;
+
+	struct Watcher {
+
+		std::filesystem::path build_file;
+		std::filesystem::path projects_path;
+		bool print_cmds = false;
+		Config_Type config_type = Config_Type::Debug;
+		u32 job_count = 0;
+		bool print_stats = false;
+		bool hash_tokens = false;
+		bool explain = false;
+
+		Parser* parser = nullptr;
+		std::unique_ptr<Parser> reloaded_parser; //Owns the parser once the build file has been changed.
+
+		int inotify_fd = -1;
+		std::unordered_map<int, std::filesystem::path> watches; //Watched directory of each watch descriptor.
+		std::unordered_map<std::string, int> watched_dirs;
+
+		~Watcher();
+
+		bool run(Parser& _parser, bool _force_rebuild);
+		bool reload_build_file();
+		void add_watches();
+		void add_watch(const std::filesystem::path& _dir);
+		bool wait_for_changes(bool& _build_file_changed);
+		bool is_relevant(const std::filesystem::path& _path, bool _is_dir);
+
+	};
+
+}
\ No newline at end of file